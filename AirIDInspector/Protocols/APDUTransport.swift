@@ -0,0 +1,211 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUTransport.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/// What a device carries in a single round trip, see `AIDDevice.commandSize`, `responseSize` and `dataBufferSize`.
+struct APDULinkLimits: Equatable {
+    /// Longest command sent at once.
+    let commandSize: Int
+    /// Longest response received at once, status word included.
+    let responseSize: Int
+    
+    /// What every device takes.
+    static let minimum = APDULinkLimits(commandSize: 266, responseSize: 258)
+    
+    /// - parameter dataBufferSize: bounds the commands too when positive.
+    init(commandSize: Int, responseSize: Int, dataBufferSize: Int = 0) {
+        // sizes read before the device was initialized are 0
+        let commandSize = commandSize > 0 ? commandSize : Self.minimum.commandSize
+        self.commandSize = dataBufferSize > 0 ? min(commandSize, dataBufferSize) : commandSize
+        self.responseSize = responseSize > 0 ? responseSize : Self.minimum.responseSize
+    }
+}
+
+/// The parts of an ISO 7816-4 command APDU, short or extended.
+struct APDUCommand: Equatable {
+    /// CLA INS P1 P2
+    let header: [UInt8]
+    let body: [UInt8]
+    /// The response length expected, 256 or 65536 for 00, nil without Le.
+    let expectedLength: Int?
+    /// Whether Lc and Le are extended fields, lengths a short command can't carry are encoded extended anyway.
+    let isExtended: Bool
+    
+    init(header: [UInt8], body: [UInt8], expectedLength: Int?, isExtended: Bool = false) {
+        self.header = header
+        self.body = body
+        self.expectedLength = expectedLength
+        self.isExtended = isExtended || body.count > 255 || (expectedLength ?? 0) > 256
+    }
+    
+    /// Nil for a malformed command, which is sent as it is.
+    init?(_ data: Data) {
+        let bytes = [UInt8](data)
+        guard bytes.count >= 4 else { return nil }
+        
+        header = Array(bytes[0..<4])
+        
+        guard bytes.count > 4 else {
+            body = []
+            expectedLength = nil
+            isExtended = false
+            return
+        }
+        
+        let length = Int(bytes[4])
+        isExtended = length == 0 && bytes.count >= 7
+        
+        if bytes.count == 5 {
+            body = []
+            expectedLength = length == 0 ? 256 : length
+        } else if length != 0, bytes.count == 5 + length || bytes.count == 6 + length {
+            body = Array(bytes[5..<5 + length])
+            expectedLength = bytes.count == 5 + length ? nil : (bytes[5 + length] == 0 ? 256 : Int(bytes[5 + length]))
+        } else if length == 0, bytes.count == 7 {
+            let extendedLength = Int(bytes[5]) << 8 | Int(bytes[6])
+            body = []
+            expectedLength = extendedLength == 0 ? 65536 : extendedLength
+        } else if length == 0, bytes.count > 7 {
+            let bodyLength = Int(bytes[5]) << 8 | Int(bytes[6])
+            guard bodyLength > 0, bytes.count == 7 + bodyLength || bytes.count == 9 + bodyLength else { return nil }
+            
+            body = Array(bytes[7..<7 + bodyLength])
+            if bytes.count == 7 + bodyLength {
+                expectedLength = nil
+            } else {
+                let extendedLength = Int(bytes[7 + bodyLength]) << 8 | Int(bytes[8 + bodyLength])
+                expectedLength = extendedLength == 0 ? 65536 : extendedLength
+            }
+        } else {
+            return nil
+        }
+    }
+    
+    /// The command in its short or extended form, a length of 256 or 65536 is sent as 00.
+    var encoded: Data {
+        var data = Data(header)
+        if isExtended, !body.isEmpty || expectedLength != nil {
+            data.append(0x00)
+        }
+        
+        if !body.isEmpty {
+            data.append(contentsOf: Self.lengthField(body.count, isExtended: isExtended))
+            data.append(contentsOf: body)
+        }
+        
+        if let expectedLength = expectedLength {
+            data.append(contentsOf: Self.lengthField(expectedLength, isExtended: isExtended))
+        }
+        
+        return data
+    }
+    
+    private static func lengthField(_ length: Int, isExtended: Bool) -> [UInt8] {
+        isExtended ? [UInt8(truncatingIfNeeded: length >> 8), UInt8(truncatingIfNeeded: length)] : [UInt8(truncatingIfNeeded: length)]
+    }
+}
+
+/**
+ The round trips of one logical APDU over a device link, following ISO 7816-4.
+ 
+ - A command longer than the link takes is split with command chaining (bit 5 of CLA) into short commands, every segment but the last has to be answered with 9000.
+ - `61XX` is followed with GET RESPONSE until the card has nothing left, the data of every response is gathered.
+ - `6CXX` sends the last command again with the Le the card asked for, once.
+ 
+ It doesn't send anything itself: send `nextCommand` and pass what came back to `receive(_:)` until `response` is set, so callback chains and async callers drive it the same way.
+ */
+struct APDUTransportExchange {
+    /// GET RESPONSE sent for a single APDU at most, 64 KB of 256 bytes.
+    static let maximumGetResponsesCount = 256
+    
+    let limits: APDULinkLimits
+    
+    /// The command to send next, nil once the exchange is complete.
+    private(set) var nextCommand: Data?
+    /// The logical response, data of every GET RESPONSE followed by the last status word.
+    private(set) var response: Data?
+    private(set) var roundTripsCount = 0
+    
+    private var segments: [Data]
+    private var gathered = Data()
+    private var getResponsesCount = 0
+    private var isLengthCorrected = false
+    
+    init(command: Data, limits: APDULinkLimits) {
+        self.limits = limits
+        self.segments = Self.segments(of: command, limits: limits)
+        self.nextCommand = segments.removeFirst()
+    }
+    
+    /// The commands `command` is sent as, a single one when it fits the link.
+    static func segments(of command: Data, limits: APDULinkLimits) -> [Data] {
+        guard command.count > limits.commandSize, let apdu = APDUCommand(command), !apdu.body.isEmpty else { return [command] }
+        
+        // CLA INS P1 P2 Lc and Le around every chunk
+        let chunkSize = max(1, min(255, limits.commandSize - 6))
+        let chainedHeader = [apdu.header[0] | 0x10] + apdu.header[1...]
+        
+        return stride(from: 0, to: apdu.body.count, by: chunkSize).map { start in
+            let end = min(start + chunkSize, apdu.body.count)
+            let isLast = end == apdu.body.count
+            
+            return APDUCommand(header: isLast ? apdu.header : chainedHeader,
+                               body: Array(apdu.body[start..<end]),
+                               expectedLength: isLast ? apdu.expectedLength.map { min($0, 256) } : nil).encoded
+        }
+    }
+    
+    /// Takes the response to `nextCommand` and decides what follows it.
+    mutating func receive(_ physicalResponse: Data) {
+        guard let command = nextCommand else { return }
+        
+        roundTripsCount += 1
+        nextCommand = nil
+        
+        guard physicalResponse.count >= 2 else {
+            complete(with: physicalResponse)
+            return
+        }
+        
+        let sw1 = physicalResponse[physicalResponse.endIndex - 2]
+        let sw2 = physicalResponse[physicalResponse.endIndex - 1]
+        
+        if !segments.isEmpty {
+            // a card refusing a segment ends the chain with its answer
+            if sw1 == 0x90, sw2 == 0x00 {
+                nextCommand = segments.removeFirst()
+            } else {
+                complete(with: physicalResponse)
+            }
+        } else if sw1 == 0x61, getResponsesCount < Self.maximumGetResponsesCount {
+            gathered.append(physicalResponse.dropLast(2))
+            getResponsesCount += 1
+            nextCommand = getResponse(after: command, length: sw2)
+        } else if sw1 == 0x6C, !isLengthCorrected, let apdu = APDUCommand(command) {
+            isLengthCorrected = true
+            // the command keeps its form, only Le changes
+            nextCommand = APDUCommand(header: apdu.header, body: apdu.body, expectedLength: sw2 == 0 ? 256 : Int(sw2), isExtended: apdu.isExtended).encoded
+        } else {
+            complete(with: physicalResponse)
+        }
+    }
+    
+    private mutating func complete(with physicalResponse: Data) {
+        response = gathered + physicalResponse
+    }
+    
+    /// GET RESPONSE in the class of `command`, for no more than the link carries.
+    private func getResponse(after command: Data, length: UInt8) -> Data {
+        let available = length == 0 ? 256 : Int(length)
+        let expectedLength = min(available, limits.responseSize - 2, 256)
+        let cla = (command.first ?? 0) & ~0x10
+        
+        return APDUCommand(header: [cla, 0xC0, 0x00, 0x00], body: [], expectedLength: expectedLength).encoded
+    }
+}
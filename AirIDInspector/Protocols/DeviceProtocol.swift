@@ -23,18 +23,33 @@ protocol DeviceProtocol: AnyObject {
     
     var cardStatus: AnyPublisher<CardStatus, Never> { get }
     
+    /// what the device carries in a single round trip
+    var linkLimits: APDULinkLimits { get }
+    
     /// returns the ATR of the card upon the wake up
     func wakeUp() async throws -> Data
     
     /// sends an APDU data to the card, and returns the resopnse
     func sendAPDU(with data: Data) async throws -> Data
     
+    /// sends an APDU like `sendAPDU(with:)`, returns it timed with the round trips it took
+    func exchangeAPDU(with data: Data) async throws -> APDUExchange
+    
+    /// sends the APDUs back to back, returns a timed exchange per APDU, a failing APDU throws `APDUBatchError` with the exchanges before it
+    func sendAPDUs(with commands: [Data]) async throws -> [APDUExchange]
+    
     /// sends a method to select protocol
     func selectProtocol(cardProtocol: AIPCardProtocol) async throws
     
     /// shuts down the card upon finishing
     func shutDown() async throws
     
+    /// holds the card for the APDUs sent until `endTransaction(disposition:)`
+    func beginTransaction() async throws
+    
+    /// releases the card held by `beginTransaction()`, then leaves it, resets it or powers it down
+    func endTransaction(disposition: APDUTransactionDisposition) async throws
+    
     /// connects the device to the iOS
     func connect() async throws
     
@@ -42,7 +57,61 @@ protocol DeviceProtocol: AnyObject {
     func disconnect() async throws
 }
 
+/// A command and its response, timestamps are `DispatchTime` uptime nanoseconds.
+struct APDUExchange {
+    let response: Data
+    let sentAt: UInt64
+    let receivedAt: UInt64
+    /// Commands which went over the link for this one, with chaining and GET RESPONSE, see `APDUTransportExchange`.
+    var roundTripsCount = 1
+    
+    var duration: MeasurementNanoseconds {
+        receivedAt - sentAt
+    }
+}
+
+struct APDUBatchError: LocalizedError {
+    /// The exchanges completed before the failing command.
+    let exchanges: [APDUExchange]
+    let underlyingError: Error
+    
+    var errorDescription: String? {
+        underlyingError.localizedDescription
+    }
+}
+
+extension DeviceProtocol {
+    func exchangeAPDU(with data: Data) async throws -> APDUExchange {
+        let sentAt = DispatchTime.now().uptimeNanoseconds
+        let response = try await sendAPDU(with: data)
+        return APDUExchange(response: response, sentAt: sentAt, receivedAt: DispatchTime.now().uptimeNanoseconds)
+    }
+    
+    func sendAPDUs(with commands: [Data]) async throws -> [APDUExchange] {
+        var exchanges: [APDUExchange] = []
+        exchanges.reserveCapacity(commands.count)
+        
+        for command in commands {
+            let sentAt = DispatchTime.now().uptimeNanoseconds
+            do {
+                let response = try await sendAPDU(with: command)
+                exchanges.append(APDUExchange(response: response, sentAt: sentAt, receivedAt: DispatchTime.now().uptimeNanoseconds))
+            } catch {
+                throw APDUBatchError(exchanges: exchanges, underlyingError: error)
+            }
+        }
+        
+        return exchanges
+    }
+}
+
 class MockedDevice: DeviceProtocol, ObservableObject {
+    struct DisconnectedError: LocalizedError {
+        var errorDescription: String? {
+            "Device disconnected"
+        }
+    }
+    
     var id: UUID
     var signalStrength: AnyPublisher<DeviceSignalStrength, Never>
     var name: AnyPublisher<String, Never>
@@ -55,7 +124,20 @@ class MockedDevice: DeviceProtocol, ObservableObject {
     var cardStatusSubject: CurrentValueSubject<CardStatus, Never>
     
     private var nextExpectedResponse: Data?
-        
+    
+    /// Nanoseconds a mocked APDU takes, picked at random for every APDU.
+    var responseDelay: ClosedRange<UInt64> = 1_000_000_000...5_000_000_000
+    
+    /// The number of APDUs answered before the device drops, nil to never drop.
+    var disconnectsAfter: Int?
+    
+    var linkLimits = APDULinkLimits.minimum
+    
+    /// Nanoseconds added to every APDU sent outside a transaction, the cost of getting exclusive access to the card.
+    var exclusiveAccessDelay: UInt64 = 0
+    
+    private(set) var isInTransaction = false
+    
     internal init(id: UUID, signalStrength: DeviceSignalStrength, name: String? = nil, status: DeviceStatus) {
         self.id = id
         self.signalSubject = CurrentValueSubject(signalStrength)
@@ -83,7 +165,17 @@ class MockedDevice: DeviceProtocol, ObservableObject {
     }
     
     func sendAPDU(with data: Data) async throws -> Data {
-        try await Task.sleep(nanoseconds: 1_000_000_000 * UInt64.random(in: 1...5))
+        try await Task.sleep(nanoseconds: UInt64.random(in: responseDelay) + (isInTransaction ? 0 : exclusiveAccessDelay))
+        
+        if let remaining = disconnectsAfter {
+            guard remaining > 0 else {
+                statusSubject.send(.present)
+                throw DisconnectedError()
+            }
+            
+            disconnectsAfter = remaining - 1
+        }
+        
         return nextExpectedResponse ?? data
     }
     
@@ -92,7 +184,16 @@ class MockedDevice: DeviceProtocol, ObservableObject {
     }
     
     func shutDown() async throws {
-        
+        isInTransaction = false
+    }
+    
+    func beginTransaction() async throws {
+        try await Task.sleep(nanoseconds: exclusiveAccessDelay)
+        isInTransaction = true
+    }
+    
+    func endTransaction(disposition: APDUTransactionDisposition) async throws {
+        isInTransaction = false
     }
     
     static func mocked() -> MockedDevice {
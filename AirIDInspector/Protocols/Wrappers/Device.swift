@@ -17,6 +17,12 @@ class DeviceWrapper: DeviceProtocol {
         }
     }
     
+    struct TransactionError: LocalizedError {
+        var errorDescription: String? {
+            "The card couldn't be held for a transaction"
+        }
+    }
+    
     let device: AIDDevice
     let card: AIDCard
     
@@ -28,6 +34,9 @@ class DeviceWrapper: DeviceProtocol {
     
     var connectionSuccess: (() -> Void)?
     
+    /// Set between `beginTransaction()` and `endTransaction(disposition:)`, a shut down card is released too.
+    private var isInTransaction = false
+    
     var signalStrength: AnyPublisher<DeviceSignalStrength, Never> {
         signalSubject.eraseToAnyPublisher()
     }
@@ -100,24 +109,110 @@ class DeviceWrapper: DeviceProtocol {
         return response
     }
     
+    /// What the device carries in a round trip, read when sending since the device may only know once it's initialized.
+    var linkLimits: APDULinkLimits {
+        APDULinkLimits(commandSize: Int(device.commandSize), responseSize: Int(device.responseSize), dataBufferSize: Int(device.dataBufferSize))
+    }
+    
     func sendAPDU(with data: Data) async throws -> Data {
-        let response: Data = try await withCheckedThrowingContinuation { continuation in
-            self.card.sendAPDU(with: data, withIORequest: nil) { response, _, error in
+        try await exchangeAPDU(with: data).response
+    }
+    
+    /// A cancelled task gets a `CancellationError` once the round trip on the link is back, so the card isn't handed over while it still answers. Nothing is sent after it.
+    func exchangeAPDU(with data: Data) async throws -> APDUExchange {
+        let call = DriverCall<APDUExchange>()
+        
+        return try await withTaskCancellationHandler {
+            try await withCheckedThrowingContinuation { continuation in
+                guard call.start(continuation) else { return }
+                
+                self.exchange(data, limits: self.linkLimits, isCancelled: { call.isCancelled }) { result in
+                    call.resume(with: result)
+                }
+            }
+        } onCancel: {
+            call.cancel(throwing: nil)
+        }
+    }
+    
+    /// Chains the commands from the card callbacks, so the whole batch costs a single continuation. A cancelled task stops the chain before the next command.
+    func sendAPDUs(with commands: [Data]) async throws -> [APDUExchange] {
+        guard !commands.isEmpty else { return [] }
+        
+        let call = DriverCall<[APDUExchange]>()
+        let limits = linkLimits
+        
+        return try await withTaskCancellationHandler {
+            try await withCheckedThrowingContinuation { continuation in
+                guard call.start(continuation) else { return }
+                
+                var exchanges: [APDUExchange] = []
+                exchanges.reserveCapacity(commands.count)
+                
+                func send(_ index: Int) {
+                    self.exchange(commands[index], limits: limits, isCancelled: { call.isCancelled }) { result in
+                        switch result {
+                        case .failure(let error):
+                            call.resume(with: .failure(APDUBatchError(exchanges: exchanges, underlyingError: error)))
+                            return
+                        case .success(let exchange):
+                            exchanges.append(exchange)
+                        }
+                        
+                        if index + 1 == commands.count {
+                            call.resume(with: .success(exchanges))
+                        } else if call.isCancelled {
+                            call.resume(with: .failure(APDUBatchError(exchanges: exchanges, underlyingError: CancellationError())))
+                        } else {
+                            send(index + 1)
+                        }
+                    }
+                }
+                
+                send(0)
+            }
+        } onCancel: {
+            // the exchanges so far are only known from the chain, it stops at the next response
+            call.cancel(throwing: nil)
+        }
+    }
+    
+    /// Sends `command` as one logical APDU, the chained segments and GET RESPONSE it takes are sent from the card callbacks. Once `isCancelled`, it completes with a `CancellationError` instead of sending the next one.
+    private func exchange(_ command: Data, limits: APDULinkLimits, isCancelled: @escaping () -> Bool, completion: @escaping (Result<APDUExchange, Error>) -> Void) {
+        var transport = APDUTransportExchange(command: command, limits: limits)
+        let sentAt = DispatchTime.now().uptimeNanoseconds
+        
+        func transmit(_ physicalCommand: Data) {
+            self.card.sendAPDU(with: physicalCommand, withIORequest: nil) { response, _, error in
                 guard let response = response else {
-                    continuation.resume(throwing: error ?? NotFoundError())
+                    completion(.failure(error ?? NotFoundError()))
                     return
                 }
                 
-                continuation.resume(returning: response)
+                transport.receive(response)
+                
+                if let next = transport.nextCommand {
+                    guard !isCancelled() else {
+                        completion(.failure(CancellationError()))
+                        return
+                    }
+                    
+                    transmit(next)
+                } else {
+                    completion(.success(APDUExchange(response: transport.response ?? response,
+                                                     sentAt: sentAt,
+                                                     receivedAt: DispatchTime.now().uptimeNanoseconds,
+                                                     roundTripsCount: transport.roundTripsCount)))
+                }
             }
         }
-
-        return response
+        
+        transmit(transport.nextCommand!)
     }
     
     func selectProtocol(cardProtocol: AIPCardProtocol) async throws {
         let _: Void = try await withCheckedThrowingContinuation({ continuation in
-            self.card.setProtocol(.T1) { error in
+            self.card.setProtocol(cardProtocol) { error in
                 if let error = error {
                     continuation.resume(throwing: error)
                     return
@@ -129,6 +224,11 @@ class DeviceWrapper: DeviceProtocol {
     }
     
     func shutDown() async throws {
+        if isInTransaction {
+            isInTransaction = false
+            card.endTransaction()
+        }
+        
         let _: Void = try await withCheckedThrowingContinuation { continuation in
             self.card.shutdownCard { error in
                 if let error = error {
@@ -141,6 +241,33 @@ class DeviceWrapper: DeviceProtocol {
         }
     }
     
+    /// Holding the card twice is a no-op, a run which failed inside a transaction still holds it.
+    func beginTransaction() async throws {
+        guard !isInTransaction else { return }
+        guard card.beginTransaction() else { throw TransactionError() }
+        
+        isInTransaction = true
+    }
+    
+    /**
+     `AIDCard` only ends transactions with `SCARD_LEAVE_CARD`, the disposition is applied once the card is released: a reset is a warm reset and unpowering shuts the card down.
+     */
+    func endTransaction(disposition: APDUTransactionDisposition) async throws {
+        if isInTransaction {
+            isInTransaction = false
+            card.endTransaction()
+        }
+        
+        switch disposition {
+        case .leave:
+            break
+        case .reset:
+            _ = try await wakeUp()
+        case .unpower:
+            try await shutDown()
+        }
+    }
+    
     func connect() async throws {
         try await manager.connect(device: self)
     }
@@ -149,3 +276,50 @@ class DeviceWrapper: DeviceProtocol {
         try await manager.disconnect(device: self)
     }
 }
+
+/// Resumes the continuation of a driver call once, from the driver callback or from the cancelled task, whichever comes first.
+private final class DriverCall<Value> {
+    private let lock = NSLock()
+    private var continuation: CheckedContinuation<Value, Error>?
+    private var cancelled = false
+    
+    var isCancelled: Bool {
+        lock.lock()
+        defer { lock.unlock() }
+        return cancelled
+    }
+    
+    /// Returns false, after resuming it, when the task was cancelled before the call was made.
+    func start(_ continuation: CheckedContinuation<Value, Error>) -> Bool {
+        lock.lock()
+        guard !cancelled else {
+            lock.unlock()
+            continuation.resume(throwing: CancellationError())
+            return false
+        }
+        
+        self.continuation = continuation
+        lock.unlock()
+        return true
+    }
+    
+    func resume(with result: Result<Value, Error>) {
+        lock.lock()
+        let continuation = self.continuation
+        self.continuation = nil
+        lock.unlock()
+        
+        continuation?.resume(with: result)
+    }
+    
+    /// Marks the call cancelled, and resumes it with `error` unless it's nil.
+    func cancel(throwing error: Error?) {
+        lock.lock()
+        cancelled = true
+        lock.unlock()
+        
+        if let error = error {
+            resume(with: .failure(error))
+        }
+    }
+}
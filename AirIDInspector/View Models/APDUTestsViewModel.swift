@@ -13,29 +13,138 @@ import AirIDDriver
 @MainActor
 class APDUTestsViewModel: ObservableObject {
     
-    @Published var operations: [APDUBaseOperation] = []
+    /// The loaded test, rows are displayed and run straight from the table.
+    @Published private(set) var table = APDUOperationTable() {
+        didSet {
+            // rows changing state refresh the views observing the view model
+            tableObservation = table.objectWillChange.sink { [weak self] _ in
+                self?.objectWillChange.send()
+            }
+        }
+    }
+    
+    /// Latency distributions of the loaded rows over all previous runs, by content addressed id.
+    @Published private(set) var histories: [UUID: APDULatencyHistogram] = [:]
+    
+    enum ExecutionMode: String, CaseIterable, Identifiable {
+        /// one row after the other, every row is published before the next one is sent
+        case serial
+        /// see `APDUPipelinedRunner`
+        case pipelined
+        /// one after the other, contiguous READ BINARY rows merged, see `APDUReadCoalescer`
+        case coalesced
+        
+        var id: String {
+            rawValue
+        }
+    }
+    
+    @Published var executionMode: ExecutionMode = .serial
+    
+    /// What happens to the card between the iterations of `start(count:)`.
+    enum RunPolicy: String, CaseIterable, Identifiable {
+        /// the card is shut down after every iteration, every iteration pays a full power up
+        case cold
+        /// the card stays powered, the header rows of the next iteration reset it
+        case warmReset
+        /// the card stays powered and header rows matching the live card are skipped
+        case keepPowered
+        
+        var id: String {
+            rawValue
+        }
+        
+        var name: String {
+            switch self {
+            case .cold: return "Cold"
+            case .warmReset: return "Warm Reset"
+            case .keepPowered: return "Keep Powered"
+            }
+        }
+    }
+    
+    @Published var runPolicy: RunPolicy = .cold
+    
+    /// How much the operations of the loaded script share, nil for sources which don't parse a script.
+    @Published private(set) var interningReport: APDUInterningTable.Report?
+    /// Latencies and inter-command gaps of the last table run.
+    @Published private(set) var lastRunReport: APDURunReport?
+    /// Latencies of the last run on a schedule, see `startLoad(_:)`.
+    @Published private(set) var lastLoadReport: APDULoadReport?
+    /// Rolling statistics of the running or last soak run, see `startSoak(_:)`.
+    @Published private(set) var lastSoakReport: APDUSoakReport?
+    @Published private(set) var isSoaking = false
+    /// Per command latencies against latencies within a transaction, see `startTransactionBenchmark(_:)`.
+    @Published private(set) var lastTransactionBenchmark: APDUTransactionBenchmarkReport?
+    /// Latencies and responses under T=0 against T=1, see `startProtocolComparison(_:)`.
+    @Published private(set) var lastProtocolComparison: APDUProtocolComparisonReport?
+    
+    /// Queue depth and wait times of the card, as of the last job which ran.
+    @Published private(set) var schedulerMetrics: APDUDeviceScheduler.Metrics?
+    
     @Published var error: Error?
     @Published var isOperationsRunning: Bool = false
     
+    /// Scripts with `REPEAT` are streamed by `start(streaming:)`, whatever `executionMode` and `runPolicy` are, and `table` is only their outline.
+    var isStreamingSource: Bool {
+        (source as? APDUTestStreamingSourceProtocol)?.containsDirectives == true
+    }
+    
     @Published var source: APDUTestSourceProtocol? {
         didSet {
+            loadingTask?.cancel()
+            fileWatcher?.stop()
+            fileWatcher = nil
+            interningReport = nil
             guard let source = self.source else { return }
             
-            do {
-                self.operations = try source.getAPDUTestOperations(for: device)
-            } catch {
-                self.error = error
-                return
+            fileWatcher = (source as? APDUTestSourceFile)?.watch { [weak self] in
+                Task { @MainActor in
+                    self?.reloadSource()
+                }
+            }
+            
+            // parsing happens off the main actor, only the result is published here
+            loadingTask = Task {
+                do {
+                    let table = try await source.loadAPDUOperationTable(for: device)
+                    try Task.checkCancellation()
+                    self.table = table
+                    self.interningReport = source.interningReport
+                    self.histories = try await APDUMeasurementHistory.current.histograms(for: table.uniqueIdentifiers)
+                } catch is CancellationError {
+                    return
+                } catch {
+                    self.error = error
+                }
             }
         }
     }
     
     let device: DeviceProtocol
-    let runner: APDUTestsRunner
+    /// Runs started here wait for the card behind the other runs of the device.
+    let scheduler: APDUDeviceScheduler
+    
+    private var loadingTask: Task<Void, Never>?
+    private var soakTask: Task<Void, Never>?
+    private var tableObservation: AnyCancellable?
+    private var fileWatcher: APDUScriptFileWatcher?
+    /// Set when the script changed while running, the table is only swapped once the run is over.
+    private var isReloadPending = false
+    /// The card left powered by the last iteration, nil once it's shut down or taken out.
+    private var cardSession: APDUCardSession?
+    private var cardStatusObservation: AnyCancellable?
     
     init(device: DeviceProtocol) {
         self.device = device
-        self.runner = .init()
+        self.scheduler = .shared(for: device)
+        
+        // a card taken out loses whatever the last run set up
+        cardStatusObservation = device.cardStatus.removeDuplicates().dropFirst().receive(on: DispatchQueue.main).sink { [weak self] status in
+            if status == .absent {
+                self?.cardSession = nil
+            }
+        }
     }
     
     func initializeSnapshotIfNeeded() {
@@ -46,47 +155,194 @@ class APDUTestsViewModel: ObservableObject {
         }
     }
     
+    /// Reparses the source after it changed, keeping the measurements of the pairs which weren't edited.
+    private func reloadSource() {
+        guard let source = source else { return }
+        
+        guard !isOperationsRunning else {
+            isReloadPending = true
+            return
+        }
+        
+        isReloadPending = false
+        loadingTask?.cancel()
+        loadingTask = Task { [table] in
+            do {
+                let reloaded = try await source.reloadAPDUOperationTable(for: device, replacing: table)
+                try Task.checkCancellation()
+                self.table = reloaded
+                self.interningReport = source.interningReport
+                self.histories = try await APDUMeasurementHistory.current.histograms(for: reloaded.uniqueIdentifiers)
+            } catch is CancellationError {
+                return
+            } catch {
+                self.error = error
+            }
+        }
+    }
+    
     func saveSnapshotIfNeeded() {
         Task {
-            if !operations.isEmpty {
-                // create a snapshot from the current operations
-                let snapshot = APDUTestSourceSnapshot(operations: operations)
-                await APDUSourceSnapshotStore.current.store(snapshot: snapshot, for: device.id)
+            if table.count > 0 {
+                // encode the current operations here, the store only appends the bytes to its log
+                let data = APDUSnapshotFormat.encode(table.operations(for: device), deviceIdentifier: device.id)
+                
+                do {
+                    try await APDUSourceSnapshotStore.current.store(snapshotData: data, for: device.id)
+                } catch {
+                    self.error = error
+                }
             }
         }
     }
     
-    func start() async throws {
+    /// Runs the table once, `isLastIteration` tells whether the card is shut down whatever the run policy.
+    func start(isLastIteration: Bool = true) async throws {
+        let measurementsMark = table.measurementsCount
+        
         defer {
             isOperationsRunning = false
+            recordHistory(table.measurements(since: measurementsMark))
+            
+            if isReloadPending {
+                reloadSource()
+            }
+        }
+        
+        // the table of a script with directives is only its outline, the expanded plan is streamed
+        if let source = source as? APDUTestStreamingSourceProtocol, source.containsDirectives {
+            return try await start(streaming: source, isLastIteration: isLastIteration)
         }
         
         await MainActor.run { isOperationsRunning = true }
         
-        for operation in operations {
+        var report = APDURunReport()
+        var rows = table.indices
+        
+        if runPolicy == .keepPowered, let session = cardSession {
+            // the header already ran on the live card, its rows keep their last state
+            let skipped = table.leadingHeaderRows.prefix { session.isRedundant($0, of: table) }
+            rows = skipped.upperBound..<table.count
+            
+            // so did a setup block nothing undid since
+            if let fixtureRows = table.fixtureRows, fixtureRows.lowerBound == rows.lowerBound, session.isFixtureEstablished(in: table) {
+                rows = fixtureRows.upperBound..<table.count
+            }
+        }
+        
+        let isCompleted = await executionMode.run(table, rows: rows, on: device, report: &report)
+        followCardSession(through: rows, isCompleted: isCompleted)
+        
+        try await shutDownIfNeeded(isLastIteration: isLastIteration, report: &report)
+        
+        lastRunReport = report
+    }
+    
+    /// Keeps track of what the header rows which ran, the setup block and the transactions resetting the card, left the card with.
+    private func followCardSession(through rows: Range<Int>, isCompleted: Bool) {
+        guard isCompleted else {
+            // the card may be anywhere, the next iteration sets it up again
+            cardSession = nil
+            return
+        }
+        
+        var session = cardSession ?? APDUCardSession()
+        let fixtureEnd = table.fixtureRows.map { [$0.upperBound - 1] } ?? []
+        
+        // in the order they ran, a transaction within the setup may reset the card before the setup is over
+        let changingRows = Array(table.leadingHeaderRows.clamped(to: rows)) + table.transactionRows(in: rows) + fixtureEnd.filter(rows.contains)
+        changingRows.sorted().forEach { session.apply($0, of: table) }
+        cardSession = session
+    }
+    
+    private func shutDownIfNeeded(isLastIteration: Bool, report: inout APDURunReport) async throws {
+        guard runPolicy == .cold || isLastIteration else { return }
+        
+        cardSession = nil
+        let startedAt = DispatchTime.now().uptimeNanoseconds
+        try await device.shutDown()
+        report.recordPowerCycling(from: startedAt, to: DispatchTime.now().uptimeNanoseconds)
+    }
+    
+    /// Adds durations measured by a run to the persistent history.
+    private func recordHistory(_ measurements: [(UUID, MeasurementNanoseconds)]) {
+        guard !measurements.isEmpty else { return }
+        updateHistory { try await $0.record(measurements) }
+    }
+    
+    /// Adds histograms folded during a run to the persistent history.
+    private func recordHistory(_ histograms: [UUID: APDULatencyHistogram]) {
+        guard !histograms.isEmpty else { return }
+        updateHistory { try await $0.merge(histograms) }
+    }
+    
+    private func updateHistory(_ update: @escaping (APDUMeasurementHistory) async throws -> Void) {
+        Task {
+            let history = APDUMeasurementHistory.current
+            
             do {
-                try await operation.tryStart()
-                await operation.state(to: .success)
+                try await update(history)
+                try await history.save()
+                self.histories = try await history.histograms(for: self.table.uniqueIdentifiers)
             } catch {
-                if error is CancellationError {
-                    await operation.state(to: .failed(.cancelled))
-                } else {
-                    await operation.state(to: .failed(.explicit(error.localizedDescription)))
-                }
-                
-                break
+                self.error = error
             }
         }
+    }
+    
+    /**
+     Runs the operations of a streaming source while the source is still parsing them.
+     
+     Operations aren't kept around after they ran, so this is meant for scripts too large to be loaded into `operations`. They run one by one on a cold card: the execution mode, the run policy and the setup block caching don't apply, and the rows of `table` aren't updated. The UI says so for such scripts, see `isStreamingSource`.
+     */
+    func start(streaming source: APDUTestStreamingSourceProtocol, isLastIteration: Bool = true) async throws {
+        defer {
+            isOperationsRunning = false
+        }
         
+        isOperationsRunning = true
         
-        try await device.shutDown()
+        // streamed operations are dropped once they ran, their durations are folded per id so memory follows the unique APDUs
+        var histograms: [UUID: APDULatencyHistogram] = [:]
+        defer { recordHistory(histograms) }
+        
+        for try await operation in source.operationStream(for: device) {
+            let isRunning = await run(operation)
+            operation.measurements.durations.forEach { histograms[operation.id, default: .init()].record($0) }
+            guard isRunning else { break }
+        }
+        
+        // streamed header operations aren't followed, every iteration sets the card up again
+        cardSession = nil
+        if runPolicy == .cold || isLastIteration {
+            try await device.shutDown()
+        }
+    }
+    
+    /// Runs a single operation, returns false if the run should stop.
+    private func run(_ operation: APDUBaseOperation) async -> Bool {
+        do {
+            try await operation.tryStart()
+            await operation.state(to: .success)
+            return true
+        } catch {
+            if error is CancellationError {
+                await operation.state(to: .failed(.cancelled))
+            } else {
+                await operation.state(to: .failed(.explicit(error.localizedDescription)))
+            }
+            
+            return false
+        }
     }
     
     func start(count: Int = 1) {
-        Task {
-            for _ in 0..<count {
+        schedule(.background) { @MainActor in
+            for iteration in 0..<count {
                 do {
-                    try await self.start()
+                    try await self.start(isLastIteration: iteration == count - 1)
+                } catch is CancellationError {
+                    return
                 } catch {
                     self.error = error
                 }
@@ -94,23 +350,144 @@ class APDUTestsViewModel: ObservableObject {
         }
     }
     
-    func exportTest() throws -> Data {
-        // TODO: Export the test, probably saving it to a document and then sharing the same data as JSON.
+    /// Sends a single APDU ahead of the queued runs of the device.
+    func send(_ command: Data) async throws -> Data {
+        defer { refreshSchedulerMetrics() }
+        return try await scheduler.perform(.interactive) {
+            try await self.device.sendAPDU(with: command)
+        }
+    }
+    
+    /// Runs `work` once the card is free, `error` gets what it throws. `completion` runs after it, or after the job was cancelled before it started.
+    @discardableResult
+    private func schedule(_ priority: APDUDeviceScheduler.Priority, _ work: @escaping () async throws -> Void, completion: (() -> Void)? = nil) -> Task<Void, Never> {
+        Task {
+            defer {
+                completion?()
+                refreshSchedulerMetrics()
+            }
+            
+            do {
+                try await scheduler.perform(priority, work)
+            } catch is CancellationError {
+                return
+            } catch {
+                self.error = error
+            }
+        }
+    }
+    
+    private func refreshSchedulerMetrics() {
+        Task {
+            schedulerMetrics = await scheduler.metrics
+        }
+    }
+    
+    /// Sends the APDUs of the table on the schedule of `generator` rather than one after the other.
+    func startLoad(_ generator: APDULoadGenerator) {
+        guard !isOperationsRunning else { return }
+        isOperationsRunning = true
+        
+        schedule(.background, { @MainActor in
+            let report = try await generator.run(self.table, on: self.device)
+            self.lastLoadReport = report
+            
+            self.cardSession = nil
+            try await self.device.shutDown()
+        }, completion: {
+            self.isOperationsRunning = false
+        })
+    }
+    
+    /// Sends the APDUs of the table one by one and within a transaction, in turns.
+    func startTransactionBenchmark(_ benchmark: APDUTransactionBenchmark) {
+        guard !isOperationsRunning else { return }
+        isOperationsRunning = true
+        cardSession = nil
+        
+        schedule(.background, { @MainActor in
+            do {
+                let report = try await benchmark.run(self.table, on: self.device)
+                self.lastTransactionBenchmark = report
+            } catch {
+                // shutting the card down releases it if a round failed while holding it
+                try? await self.device.shutDown()
+                throw error
+            }
+        }, completion: {
+            self.isOperationsRunning = false
+        })
+    }
+    
+    /// Sends the APDUs of the table under T=0 and under T=1, in turns.
+    func startProtocolComparison(_ comparison: APDUProtocolComparison) {
+        guard !isOperationsRunning else { return }
+        isOperationsRunning = true
+        cardSession = nil
         
-        let encoder = JSONEncoder()
-        encoder.keyEncodingStrategy = .convertToSnakeCase
+        schedule(.background, { @MainActor in
+            do {
+                let report = try await comparison.run(self.table, on: self.device)
+                self.lastProtocolComparison = report
+            } catch {
+                try? await self.device.shutDown()
+                throw error
+            }
+        }, completion: {
+            self.isOperationsRunning = false
+        })
+    }
+    
+    /// Runs the table until the budget of `runner` is spent or `stopSoak()` is called.
+    func startSoak(_ runner: APDUSoakRunner) {
+        guard !isOperationsRunning else { return }
+        isOperationsRunning = true
+        isSoaking = true
+        cardSession = nil
         
-        return try encoder.encode(self.operations)
+        soakTask = schedule(.background, { @MainActor in
+            do {
+                let report = try await runner.run(self.table, on: self.device) { [weak self] report in
+                    self?.lastSoakReport = report
+                }
+                
+                self.lastSoakReport = report
+            } catch is CancellationError {
+                try? await self.device.shutDown()
+            }
+        }, completion: {
+            self.isOperationsRunning = false
+            self.isSoaking = false
+            self.soakTask = nil
+        })
+    }
+    
+    func stopSoak() {
+        soakTask?.cancel()
+    }
+    
+    func exportTest(format: APDUTestSourceSnapshot.Format = .json) throws -> Data {
+        // TODO: Export the test, probably saving it to a document and then sharing the same data.
+        try APDUTestSourceSnapshot.data(for: table.operations(for: device), deviceIdentifier: device.id, format: format)
     }
 }
 
-actor APDUTestsRunner {
-    private var previousTask: Task<(), Error>?
-
-    func add(block: @Sendable @escaping () async throws -> Void) {
-        previousTask = Task { [previousTask] in
-            let _ = await previousTask?.result
-            return try await block()
+extension APDUTestsViewModel.ExecutionMode {
+    /// Runs `rows` of `table` on `device`, returns false if the run stopped before the last row.
+    @MainActor
+    func run(_ table: APDUOperationTable, rows: Range<Int>, on device: DeviceProtocol, report: inout APDURunReport) async -> Bool {
+        switch self {
+        case .serial:
+            for row in rows {
+                guard await table.run(row, on: device, report: &report) else { return false }
+            }
+            
+            return true
+        case .pipelined:
+            return await APDUPipelinedRunner().run(table, rows: rows, on: device, report: &report)
+        case .coalesced:
+            return await APDUReadCoalescer().run(table, rows: rows, on: device, report: &report)
         }
     }
 }
+
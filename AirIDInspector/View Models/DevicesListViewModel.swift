@@ -19,6 +19,12 @@ class DevicesListViewModel<DevicesManager: DevicesManagerProtocol>: ObservableOb
     @Published var savedDevice: DeviceViewModel? = nil
     @Published var error: Error?
     
+    /// The report of the last run on all the connected devices.
+    @Published private(set) var fleetReport: APDUFleetReport?
+    @Published private(set) var isFleetRunning = false
+    /// The report of the last run of independent scripts spread over the connected devices.
+    @Published private(set) var shardReport: APDUShardReport?
+    
     private var _deviceManager: DevicesManager
     private var cancellables: [AnyCancellable] = []
     
@@ -44,4 +50,55 @@ class DevicesListViewModel<DevicesManager: DevicesManagerProtocol>: ObservableOb
             self.error = $0
         }.store(in: &cancellables)
     }
+    
+    /// The tests a fleet run replicates, those loaded for the saved device first, or for any connected device.
+    var fleetTestsViewModel: APDUTestsViewModel? {
+        ([savedDevice].compactMap { $0 } + connectedDevices)
+            .map(\.testsViewModel)
+            .first { $0.table.count > 0 }
+    }
+    
+    /// Runs the tests of `testsViewModel` on every connected device at once.
+    func runOnConnectedDevices(_ testsViewModel: APDUTestsViewModel) {
+        guard !isFleetRunning else { return }
+        isFleetRunning = true
+        
+        Task {
+            defer { isFleetRunning = false }
+            
+            let runner = APDUFleetRunner(executionMode: testsViewModel.executionMode)
+            let report = await runner.run(testsViewModel.table, on: connectedDevices.map(\.device))
+            fleetReport = report
+        }
+    }
+    
+    /// Runs every script of `urls` once, on whichever connected device is free first.
+    func runSharded(scriptsAt urls: [URL], executionMode: APDUTestsViewModel.ExecutionMode = .serial) {
+        guard !isFleetRunning, let loadingDevice = connectedDevices.first?.device else { return }
+        isFleetRunning = true
+        
+        Task {
+            defer { isFleetRunning = false }
+            
+            do {
+                var units: [APDUOperationTable] = []
+                for url in urls {
+                    let source = APDUTestSourceFile(url: url)
+                    let table = try await source.loadAPDUOperationTable(for: loadingDevice)
+                    
+                    // a unit's table has to be what runs, expanding REPEAT into it would take the memory streaming avoids
+                    guard !source.containsDirectives else {
+                        throw OperationError.explicit("\(url.lastPathComponent) uses REPEAT, sharded units have to be plain scripts")
+                    }
+                    
+                    units.append(table)
+                }
+                
+                let report = await APDUShardedRunner(executionMode: executionMode).run(units, on: connectedDevices.map(\.device))
+                shardReport = report
+            } catch {
+                self.error = error
+            }
+        }
+    }
 }
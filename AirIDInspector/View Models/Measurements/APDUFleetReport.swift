@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUFleetReport.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ The runs of a test on many devices at once, each with its own report, and their aggregate.
+ 
+ The aggregate merges the latencies of every device, its throughput is the APDUs of the whole fleet over the wall time of the run.
+ */
+struct APDUFleetReport: CustomStringConvertible {
+    struct DeviceRun {
+        let deviceID: UUID
+        /// The replica the device ran, with its own states and measurements.
+        let table: APDUOperationTable
+        let report: APDURunReport
+        /// The first row which failed, nil if the run went through.
+        let failedRow: Int?
+        /// Error shutting the device down after the run.
+        let error: Error?
+        
+        var isSuccessful: Bool {
+            failedRow == nil && error == nil
+        }
+    }
+    
+    private(set) var runs: [DeviceRun] = []
+    private(set) var aggregate = APDURunReport()
+    
+    init() { }
+    
+    mutating func add(_ run: DeviceRun) {
+        runs.append(run)
+        aggregate.merge(run.report)
+    }
+    
+    func run(for deviceID: UUID) -> DeviceRun? {
+        runs.first { $0.deviceID == deviceID }
+    }
+    
+    var failedRuns: [DeviceRun] {
+        runs.filter { !$0.isSuccessful }
+    }
+    
+    var description: String {
+        var lines = ["\(runs.count) devices, \(failedRuns.count) failed: \(aggregate)"]
+        
+        for run in runs.sorted(by: { $0.deviceID.uuidString < $1.deviceID.uuidString }) {
+            let status = run.failedRow.map { "failed at row \($0)" } ?? run.error.map { $0.localizedDescription } ?? "passed"
+            lines.append("\(run.deviceID.uuidString.prefix(8)) \(status): \(run.report)")
+        }
+        
+        return lines.joined(separator: "\n")
+    }
+}
@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDULatencyHistogram.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Latency distribution of an operation, with a footprint independent of the number of runs.
+ 
+ Durations are counted in log-linear buckets, 8 per power of two, so percentiles are within 12.5% of the measured durations while minimum, maximum and average stay exact.
+ */
+struct APDULatencyHistogram: Equatable, CustomStringConvertible {
+    private static let subBucketBits = 3
+    private static let subBuckets = 1 << subBucketBits
+    
+    private(set) var count: UInt64 = 0
+    private(set) var total: MeasurementNanoseconds = 0
+    private(set) var minimum: MeasurementNanoseconds = .max
+    private(set) var maximum: MeasurementNanoseconds = 0
+    private var buckets: [UInt64] = []
+    
+    init() { }
+    
+    init<Durations: Sequence>(durations: Durations) where Durations.Element == MeasurementNanoseconds {
+        durations.forEach { record($0) }
+    }
+    
+    var average: MeasurementNanoseconds {
+        count == 0 ? 0 : total / count
+    }
+    
+    mutating func record(_ duration: MeasurementNanoseconds) {
+        let bucket = Self.bucket(for: duration)
+        if bucket >= buckets.count {
+            buckets.append(contentsOf: repeatElement(0, count: bucket - buckets.count + 1))
+        }
+        
+        buckets[bucket] += 1
+        count += 1
+        total &+= duration
+        minimum = min(minimum, duration)
+        maximum = max(maximum, duration)
+    }
+    
+    mutating func merge(_ other: APDULatencyHistogram) {
+        if other.buckets.count > buckets.count {
+            buckets.append(contentsOf: repeatElement(0, count: other.buckets.count - buckets.count))
+        }
+        
+        for (bucket, count) in other.buckets.enumerated() {
+            buckets[bucket] += count
+        }
+        
+        count += other.count
+        total &+= other.total
+        minimum = min(minimum, other.minimum)
+        maximum = max(maximum, other.maximum)
+    }
+    
+    /// The duration under which `fraction` of the runs completed, nil without any run.
+    func percentile(_ fraction: Double) -> MeasurementNanoseconds? {
+        guard count > 0 else { return nil }
+        
+        let rank = max(1, UInt64((fraction * Double(count)).rounded(.up)))
+        var seen: UInt64 = 0
+        
+        for (bucket, bucketCount) in buckets.enumerated() where bucketCount > 0 {
+            seen += bucketCount
+            if seen >= rank {
+                let lower = Self.lowerBound(of: bucket)
+                let upper = Self.lowerBound(of: bucket + 1) - 1
+                return min(max(lower / 2 + upper / 2, minimum), maximum)
+            }
+        }
+        
+        return maximum
+    }
+    
+    var description: String {
+        guard let median = percentile(0.5), let tail = percentile(0.99) else {
+            return "No Measurements yet"
+        }
+        
+        return "P50: \(median.humanFormatted) P99: \(tail.humanFormatted) over \(count) runs"
+    }
+    
+    // MARK: - Buckets
+    
+    /// Values under 8 get a bucket each, then every power of two is split into 8 buckets.
+    static func bucket(for value: MeasurementNanoseconds) -> Int {
+        guard value >= subBuckets else { return Int(value) }
+        
+        let exponent = MeasurementNanoseconds.bitWidth - 1 - value.leadingZeroBitCount
+        let subBucket = Int(value >> (exponent - subBucketBits)) & (subBuckets - 1)
+        return (exponent - subBucketBits + 1) * subBuckets + subBucket
+    }
+    
+    static func lowerBound(of bucket: Int) -> MeasurementNanoseconds {
+        guard bucket >= subBuckets else { return MeasurementNanoseconds(bucket) }
+        
+        let exponent = bucket / subBuckets - 1 + subBucketBits
+        let subBucket = MeasurementNanoseconds(bucket % subBuckets)
+        guard exponent < MeasurementNanoseconds.bitWidth else { return .max }
+        
+        return (MeasurementNanoseconds(subBuckets) + subBucket) << (exponent - subBucketBits)
+    }
+    
+    // MARK: - Coding
+    
+    /// Only the used buckets are written.
+    func encode(to writer: inout APDUSnapshotWriter) {
+        writer.writeVarint(count)
+        writer.writeVarint(total)
+        writer.writeVarint(minimum)
+        writer.writeVarint(maximum)
+        
+        let used = buckets.enumerated().filter { $0.element > 0 }
+        writer.writeVarint(UInt64(used.count))
+        for (bucket, count) in used {
+            writer.writeVarint(UInt64(bucket))
+            writer.writeVarint(count)
+        }
+    }
+    
+    init(from reader: inout APDUSnapshotReader) throws {
+        count = try reader.readVarint()
+        total = try reader.readVarint()
+        minimum = try reader.readVarint()
+        maximum = try reader.readVarint()
+        
+        let usedCount = try reader.readVarint()
+        for _ in 0..<usedCount {
+            let bucket = try reader.readVarint()
+            guard bucket <= UInt64(Self.bucket(for: .max)) else {
+                throw APDUSnapshotFormat.CorruptedSnapshotError(reason: "invalid latency bucket \(bucket)")
+            }
+            
+            let index = Int(bucket)
+            if index >= buckets.count {
+                buckets.append(contentsOf: repeatElement(0, count: index - buckets.count + 1))
+            }
+            
+            buckets[index] = try reader.readVarint()
+        }
+    }
+}
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDULoadReport.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Latencies of an open loop run, see `APDULoadGenerator`.
+ 
+ `corrected` counts from the time an APDU was due, which is what a client transacting on that schedule waits. `service` counts from the time it was actually sent, what a closed loop run would report. The gap between the two is the queueing the schedule ran into.
+ */
+struct APDULoadReport: CustomStringConvertible {
+    let schedule: APDULoadGenerator.Schedule
+    private(set) var corrected = APDULatencyHistogram()
+    private(set) var service = APDULatencyHistogram()
+    /// APDUs sent after the time they were due.
+    private(set) var lateCount = 0
+    private(set) var maximumLag: MeasurementNanoseconds = 0
+    private(set) var mismatchesCount = 0
+    private(set) var startedAt: UInt64?
+    private(set) var endedAt: UInt64?
+    
+    init(schedule: APDULoadGenerator.Schedule) {
+        self.schedule = schedule
+    }
+    
+    /// An APDU due at `intendedAt`, sent at `sentAt` and answered at `receivedAt`, in `DispatchTime` uptime nanoseconds.
+    mutating func record(intendedAt: UInt64, sentAt: UInt64, receivedAt: UInt64, matches: Bool) {
+        corrected.record(receivedAt - min(intendedAt, sentAt))
+        service.record(receivedAt - sentAt)
+        
+        // sleeping wakes up a little late on its own, only count what the card held up
+        let lag = sentAt > intendedAt ? sentAt - intendedAt : 0
+        if lag > 1_000_000 {
+            lateCount += 1
+        }
+        
+        maximumLag = max(maximumLag, lag)
+        mismatchesCount += matches ? 0 : 1
+        startedAt = startedAt ?? intendedAt
+        endedAt = receivedAt
+    }
+    
+    /// APDUs answered per second.
+    var achievedRate: Double {
+        guard let startedAt = startedAt, let endedAt = endedAt, endedAt > startedAt else { return 0 }
+        return Double(corrected.count) / (Double(endedAt - startedAt) / 1_000_000_000)
+    }
+    
+    var description: String {
+        guard corrected.count > 0 else { return "No APDUs sent" }
+        
+        let percentiles = [("P50", 0.5), ("P99", 0.99), ("P99.9", 0.999)].map { name, fraction in
+            "\(name): \(corrected.percentile(fraction)!.preciseFormatted)/\(service.percentile(fraction)!.preciseFormatted)"
+        }
+        
+        return String(format: "target %.1f/s, achieved %.1f/s, ", schedule.rate, achievedRate)
+            + "corrected/service " + percentiles.joined(separator: " ")
+            + ", \(lateCount) late (max \(maximumLag.preciseFormatted)), \(mismatchesCount) mismatches"
+    }
+}
@@ -10,6 +10,7 @@ import Foundation
 
 typealias MeasurementNanoseconds = UInt64
 
+/// Durations of an operation. Equality and hashing follow the content addressed `operationID`, so the measurements of rows running the same APDU compare equal and can be combined.
 class APDUMeasurement: ObservableObject, Equatable, Hashable, Identifiable, Codable {
     let operationID: UUID
     
@@ -106,4 +107,13 @@ extension MeasurementNanoseconds {
         let milliseconds = (self / 1_000_000)
         return Self.numberFormatter.string(from: .init(value: milliseconds))! + "ms"
     }
+    
+    /// Keeps sub millisecond durations readable, e.g. the gaps between commands.
+    var preciseFormatted: String {
+        if self < 1_000_000 {
+            return String(format: "%.0fµs", Double(self) / 1_000)
+        }
+        
+        return String(format: "%.2fms", Double(self) / 1_000_000)
+    }
 }
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUMeasurementHistory.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Latency distributions of every operation ever measured, by content addressed id (`APDUOperationIdentity`).
+ 
+ Durations of all runs, scripts and devices build up in one histogram per id, which is kept across launches.
+ 
+ ```
+ header      magic "APDH" | version: UInt16
+ entries     count: varint | (id: 16 bytes | histogram)*
+ ```
+ */
+actor APDUMeasurementHistory {
+    private(set) static var current: APDUMeasurementHistory = .init(fileURL: defaultFileURL)
+    
+    private static let magic: [UInt8] = Array("APDH".utf8)
+    private static let version: UInt16 = 1
+    
+    static var defaultFileURL: URL {
+        let directory = FileManager.default.urls(for: .applicationSupportDirectory, in: .userDomainMask).first
+            ?? FileManager.default.temporaryDirectory
+        return directory.appendingPathComponent("History").appendingPathComponent("measurements.history")
+    }
+    
+    let fileURL: URL
+    
+    private var histograms: [UUID: APDULatencyHistogram] = [:]
+    private var isLoaded = false
+    private var hasChanges = false
+    
+    init(fileURL: URL) {
+        self.fileURL = fileURL
+    }
+    
+    func record<Measurements: Sequence>(_ measurements: Measurements) throws where Measurements.Element == (UUID, MeasurementNanoseconds) {
+        try loadIfNeeded()
+        
+        for (identifier, duration) in measurements {
+            histograms[identifier, default: .init()].record(duration)
+            hasChanges = true
+        }
+    }
+    
+    /// Merges histograms already folded by the caller, e.g. of a streamed run.
+    func merge(_ histograms: [UUID: APDULatencyHistogram]) throws {
+        try loadIfNeeded()
+        
+        for (identifier, histogram) in histograms where histogram.count > 0 {
+            self.histograms[identifier, default: .init()].merge(histogram)
+            hasChanges = true
+        }
+    }
+    
+    func histogram(for identifier: UUID) throws -> APDULatencyHistogram? {
+        try loadIfNeeded()
+        return histograms[identifier]
+    }
+    
+    func histograms<Identifiers: Sequence>(for identifiers: Identifiers) throws -> [UUID: APDULatencyHistogram] where Identifiers.Element == UUID {
+        try loadIfNeeded()
+        
+        var found: [UUID: APDULatencyHistogram] = [:]
+        for identifier in identifiers {
+            found[identifier] = histograms[identifier]
+        }
+        
+        return found
+    }
+    
+    /// Writes the history if it changed since it was loaded or last saved.
+    func save() throws {
+        guard hasChanges else { return }
+        
+        var writer = APDUSnapshotWriter()
+        writer.data.append(contentsOf: Self.magic)
+        writer.write(Self.version)
+        writer.writeVarint(UInt64(histograms.count))
+        
+        for (identifier, histogram) in histograms {
+            writer.write(identifier)
+            histogram.encode(to: &writer)
+        }
+        
+        try FileManager.default.createDirectory(at: fileURL.deletingLastPathComponent(), withIntermediateDirectories: true)
+        try writer.data.write(to: fileURL, options: .atomic)
+        hasChanges = false
+    }
+    
+    /// The file a damaged history is moved to before starting over.
+    nonisolated var corruptFileURL: URL {
+        fileURL.appendingPathExtension("corrupt")
+    }
+    
+    /**
+     Loads the history on first use.
+     
+     A damaged history is moved to `corruptFileURL` so the next save doesn't overwrite it, the error is thrown once and the history starts over empty.
+     */
+    private func loadIfNeeded() throws {
+        guard !isLoaded else { return }
+        
+        guard let data = try? Data(contentsOf: fileURL) else {
+            isLoaded = true
+            return
+        }
+        
+        do {
+            histograms = try Self.decode(data)
+            isLoaded = true
+        } catch {
+            try? FileManager.default.removeItem(at: corruptFileURL)
+            try FileManager.default.moveItem(at: fileURL, to: corruptFileURL)
+            isLoaded = true
+            throw error
+        }
+    }
+    
+    private static func decode(_ data: Data) throws -> [UUID: APDULatencyHistogram] {
+        guard data.count >= magic.count + 2, Array(data.prefix(magic.count)) == magic else {
+            throw APDUSnapshotFormat.CorruptedSnapshotError(reason: "not a measurement history")
+        }
+        
+        var reader = APDUSnapshotReader(data: data, offset: magic.count, limit: data.count)
+        guard try reader.read(UInt16.self) == version else {
+            throw APDUSnapshotFormat.CorruptedSnapshotError(reason: "unsupported measurement history version")
+        }
+        
+        var histograms: [UUID: APDULatencyHistogram] = [:]
+        let count = try reader.readVarint()
+        
+        for _ in 0..<count {
+            let identifier = try reader.readUUID()
+            histograms[identifier] = try APDULatencyHistogram(from: &reader)
+        }
+        
+        return histograms
+    }
+}
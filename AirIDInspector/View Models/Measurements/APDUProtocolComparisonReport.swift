@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUProtocolComparisonReport.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Latencies and responses of the same APDUs sent under T=0 and under T=1, see `APDUProtocolComparison`.
+ */
+struct APDUProtocolComparisonReport: CustomStringConvertible {
+    /// What a protocol measured over the rounds.
+    struct Measurements {
+        /// By position in `rows`.
+        private(set) var latencies: [APDULatencyHistogram]
+        /// Of a whole pass over the APDUs.
+        private(set) var totals = APDULatencyHistogram()
+        /// Of the first pass, by position in `rows`.
+        private(set) var responses: [Data] = []
+        
+        init(count: Int) {
+            latencies = Array(repeating: APDULatencyHistogram(), count: count)
+        }
+        
+        fileprivate mutating func record(_ exchanges: [APDUExchange]) {
+            for (index, exchange) in exchanges.enumerated() {
+                latencies[index].record(exchange.duration)
+            }
+            
+            totals.record(exchanges.reduce(0) { $0 + $1.duration })
+            
+            if responses.isEmpty {
+                responses = exchanges.map(\.response)
+            }
+        }
+    }
+    
+    /// A row the card answered differently under either protocol.
+    struct Difference: Equatable {
+        let row: Int
+        let t0: Data
+        let t1: Data
+    }
+    
+    /// The APDU rows of the table, in the order they were sent.
+    let rows: [Int]
+    private(set) var roundsCount = 0
+    private(set) var t0: Measurements
+    private(set) var t1: Measurements
+    
+    init(rows: [Int]) {
+        self.rows = rows
+        self.t0 = Measurements(count: rows.count)
+        self.t1 = Measurements(count: rows.count)
+    }
+    
+    mutating func record(_ exchanges: [APDUExchange], under cardProtocol: AIPCardProtocol) {
+        if cardProtocol == .T0 {
+            t0.record(exchanges)
+        } else {
+            t1.record(exchanges)
+        }
+    }
+    
+    mutating func completeRound() {
+        roundsCount += 1
+    }
+    
+    /// Nanoseconds T=1 takes over T=0 per APDU by position in `rows`, negative where T=1 is faster.
+    var deltas: [Int64] {
+        zip(t0.latencies, t1.latencies).map { Int64($1.average) - Int64($0.average) }
+    }
+    
+    /// Nanoseconds T=1 takes over T=0 for a whole pass, negative when T=1 is faster.
+    var totalDelta: Int64 {
+        Int64(t1.totals.average) - Int64(t0.totals.average)
+    }
+    
+    var differences: [Difference] {
+        zip(rows, zip(t0.responses, t1.responses)).compactMap { row, responses in
+            responses.0 == responses.1 ? nil : Difference(row: row, t0: responses.0, t1: responses.1)
+        }
+    }
+    
+    var description: String {
+        guard roundsCount > 0 else { return "No rounds run" }
+        
+        let perAPDU = zip(rows, deltas).map { "#\($0) \(Self.signed($1))" }.joined(separator: " ")
+        var description = "\(roundsCount) rounds of \(rows.count) APDUs, T=0 \(t0.totals), T=1 \(t1.totals), T=1 \(Self.signed(totalDelta)) per pass, per APDU \(perAPDU)"
+        
+        let differences = self.differences
+        if differences.isEmpty {
+            description += ", same responses"
+        } else {
+            description += ", responses differ at " + differences.map { "#\($0.row) \($0.t0.hexEncodedString())/\($0.t1.hexEncodedString())" }.joined(separator: " ")
+        }
+        
+        return description
+    }
+    
+    private static func signed(_ delta: Int64) -> String {
+        (delta < 0 ? "-" : "+") + delta.magnitude.preciseFormatted
+    }
+}
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDURunReport.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Latencies of a run together with the idle time of the link between two commands.
+ 
+ The gap of a command is the time between the previous response and the command being sent, what's left of it is the overhead of the runner: validating, publishing and preparing the next command.
+ */
+struct APDURunReport: CustomStringConvertible {
+    private(set) var latencies = APDULatencyHistogram()
+    private(set) var gaps = APDULatencyHistogram()
+    private(set) var startedAt: UInt64 = DispatchTime.now().uptimeNanoseconds
+    private(set) var endedAt: UInt64?
+    /// Time spent powering the card up with a reset and shutting it down, rather than exchanging APDUs.
+    private(set) var powerCycling: MeasurementNanoseconds = 0
+    /// Commands which went over the link, more than the APDUs when some were chained or answered with GET RESPONSE.
+    private(set) var roundTripsCount = 0
+    
+    private var lastReceivedAt: UInt64?
+    
+    init() { }
+    
+    /// Times a command sent at `sentAt` whose response arrived at `receivedAt`, in `DispatchTime` uptime nanoseconds.
+    mutating func record(sentAt: UInt64, receivedAt: UInt64, roundTripsCount: Int = 1) {
+        self.roundTripsCount += roundTripsCount
+        
+        if let lastReceivedAt = lastReceivedAt, sentAt >= lastReceivedAt {
+            gaps.record(sentAt - lastReceivedAt)
+        }
+        
+        latencies.record(receivedAt - sentAt)
+        lastReceivedAt = receivedAt
+        endedAt = receivedAt
+    }
+    
+    mutating func record(_ exchange: APDUExchange) {
+        record(sentAt: exchange.sentAt, receivedAt: exchange.receivedAt, roundTripsCount: exchange.roundTripsCount)
+    }
+    
+    /// Forgets the last response, the next command doesn't follow it, e.g. after a header operation.
+    mutating func breakGap() {
+        lastReceivedAt = nil
+    }
+    
+    /// Times a reset or a shut down of the card, the next command doesn't follow the previous response.
+    mutating func recordPowerCycling(from startedAt: UInt64, to endedAt: UInt64) {
+        powerCycling += endedAt - startedAt
+        self.endedAt = max(self.endedAt ?? endedAt, endedAt)
+        breakGap()
+    }
+    
+    mutating func merge(_ other: APDURunReport) {
+        latencies.merge(other.latencies)
+        gaps.merge(other.gaps)
+        powerCycling += other.powerCycling
+        roundTripsCount += other.roundTripsCount
+        startedAt = min(startedAt, other.startedAt)
+        endedAt = [endedAt, other.endedAt].compactMap { $0 }.max()
+    }
+    
+    var elapsed: MeasurementNanoseconds {
+        (endedAt ?? startedAt) - startedAt
+    }
+    
+    /// Commands per second over the whole run.
+    var throughput: Double {
+        elapsed == 0 ? 0 : Double(latencies.count) / (Double(elapsed) / 1_000_000_000)
+    }
+    
+    var description: String {
+        let gap = gaps.percentile(0.5).map { "gap P50: \($0.preciseFormatted) P99: \(gaps.percentile(0.99)!.preciseFormatted) avg: \(gaps.average.preciseFormatted)" } ?? "no gaps"
+        var description = "\(latencies.count) APDUs, " + String(format: "%.1f/s", throughput) + ", \(latencies), \(gap)"
+        
+        if roundTripsCount > latencies.count {
+            description += ", \(roundTripsCount) round trips"
+        }
+        
+        if powerCycling > 0, elapsed > 0 {
+            description += ", power cycling \(powerCycling.preciseFormatted) (" + String(format: "%.0f%%", Double(powerCycling) / Double(elapsed) * 100) + ")"
+        }
+        
+        return description
+    }
+}
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUShardReport.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ The units of a sharded run by the device which ran them, with the report of every device and their aggregate.
+ */
+struct APDUShardReport: CustomStringConvertible {
+    struct Worker {
+        let deviceID: UUID
+        var completedUnits: [Int] = []
+        /// Units which ran to a response mismatch, they aren't run again.
+        var failedUnits: [Int] = []
+        var report = APDURunReport()
+        /// The error which took the device out of the run.
+        var error: Error?
+    }
+    
+    let unitsCount: Int
+    private(set) var workers: [Worker] = []
+    private(set) var aggregate = APDURunReport()
+    /// Units left over when no device was left to run them.
+    var pendingUnits: [Int] = []
+    
+    init(unitsCount: Int) {
+        self.unitsCount = unitsCount
+    }
+    
+    mutating func add(_ worker: Worker) {
+        workers.append(worker)
+        aggregate.merge(worker.report)
+    }
+    
+    func worker(for deviceID: UUID) -> Worker? {
+        workers.first { $0.deviceID == deviceID }
+    }
+    
+    var completedCount: Int {
+        workers.reduce(0) { $0 + $1.completedUnits.count }
+    }
+    
+    var failedUnits: [Int] {
+        workers.flatMap(\.failedUnits).sorted()
+    }
+    
+    var description: String {
+        var lines = ["\(completedCount)/\(unitsCount) units passed, \(failedUnits.count) failed, \(pendingUnits.count) not run: \(aggregate)"]
+        
+        for worker in workers.sorted(by: { $0.completedUnits.count > $1.completedUnits.count }) {
+            let status = worker.error.map { "dropped: \($0.localizedDescription)" } ?? "\(worker.completedUnits.count) units"
+            lines.append("\(worker.deviceID.uuidString.prefix(8)) \(status): \(worker.report)")
+        }
+        
+        return lines.joined(separator: "\n")
+    }
+}
@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUSoakReport.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Statistics of a soak run, see `APDUSoakRunner`.
+ 
+ Exchanges are counted into fixed length windows of time, only the last `capacity` windows are kept next to the totals of the whole run, so the report takes the same memory after a minute or after a day.
+ */
+struct APDUSoakReport: CustomStringConvertible {
+    struct Window: CustomStringConvertible {
+        /// The index of the window since the start of the run.
+        let sequence: UInt64
+        private(set) var latencies = APDULatencyHistogram()
+        private(set) var mismatchesCount = 0
+        /// APDUs sent again after a transient failure.
+        private(set) var retriesCount = 0
+        private(set) var reconnectsCount = 0
+        /// Iterations given up after their retries ran out.
+        private(set) var failuresCount = 0
+        
+        init(sequence: UInt64) {
+            self.sequence = sequence
+        }
+        
+        mutating func merge(_ other: Window) {
+            latencies.merge(other.latencies)
+            mismatchesCount += other.mismatchesCount
+            retriesCount += other.retriesCount
+            reconnectsCount += other.reconnectsCount
+            failuresCount += other.failuresCount
+        }
+        
+        var description: String {
+            "\(latencies), \(mismatchesCount) mismatches, \(retriesCount) retries, \(reconnectsCount) reconnects, \(failuresCount) failures"
+        }
+    }
+    
+    /// Nanoseconds covered by a window.
+    let windowDuration: UInt64
+    /// The number of windows kept.
+    let capacity: Int
+    let startedAt: UInt64
+    
+    /// The last windows, oldest first.
+    private(set) var windows: [Window] = []
+    /// The whole run.
+    private(set) var total = Window(sequence: 0)
+    private(set) var iterationsCount = 0
+    private(set) var lastError: Error?
+    
+    init(windowDuration: UInt64, capacity: Int, startedAt: UInt64 = DispatchTime.now().uptimeNanoseconds) {
+        precondition(windowDuration > 0 && capacity > 0)
+        self.windowDuration = windowDuration
+        self.capacity = capacity
+        self.startedAt = startedAt
+        
+        windows.reserveCapacity(capacity)
+    }
+    
+    // MARK: - Recording
+    
+    /// Times are `DispatchTime` uptime nanoseconds.
+    mutating func record(sentAt: UInt64, receivedAt: UInt64, matches: Bool) {
+        update(at: receivedAt) {
+            $0.latencies.record(receivedAt - sentAt)
+            $0.mismatchesCount += matches ? 0 : 1
+        }
+    }
+    
+    mutating func recordRetry(at time: UInt64) {
+        update(at: time) { $0.retriesCount += 1 }
+    }
+    
+    mutating func recordReconnect(at time: UInt64) {
+        update(at: time) { $0.reconnectsCount += 1 }
+    }
+    
+    mutating func recordFailure(_ error: Error, at time: UInt64) {
+        lastError = error
+        update(at: time) { $0.failuresCount += 1 }
+    }
+    
+    mutating func completeIteration() {
+        iterationsCount += 1
+    }
+    
+    private mutating func update(at time: UInt64, _ change: (inout Window) -> Void) {
+        advance(to: time)
+        change(&windows[windows.count - 1])
+        change(&total)
+    }
+    
+    /// Opens the window of `time`, windows without any exchange in between are kept empty.
+    private mutating func advance(to time: UInt64) {
+        let sequence = time > startedAt ? (time - startedAt) / windowDuration : 0
+        let next = windows.last.map { $0.sequence + 1 } ?? 0
+        guard windows.isEmpty || sequence >= next else { return }
+        
+        // older windows would be dropped right away
+        let first = max(next, sequence >= UInt64(capacity) ? sequence - UInt64(capacity) + 1 : 0)
+        if first > next {
+            windows.removeAll(keepingCapacity: true)
+        }
+        
+        for sequence in first...sequence {
+            windows.append(Window(sequence: sequence))
+        }
+        
+        if windows.count > capacity {
+            windows.removeFirst(windows.count - capacity)
+        }
+    }
+    
+    // MARK: - Reading
+    
+    /// The kept windows merged together.
+    var recent: Window {
+        windows.reduce(into: Window(sequence: windows.first?.sequence ?? 0)) { $0.merge($1) }
+    }
+    
+    var description: String {
+        var description = "\(iterationsCount) iterations, total: \(total)"
+        if let last = windows.last {
+            description += ", last window: \(last)"
+        }
+        
+        return description
+    }
+}
@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUTransactionBenchmarkReport.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Latencies of the same APDUs sent one by one and within a single transaction, see `APDUTransactionBenchmark`.
+ */
+struct APDUTransactionBenchmarkReport: CustomStringConvertible {
+    /// APDUs sent by every pass of either variant.
+    let apdusPerRound: Int
+    private(set) var roundsCount = 0
+    /// APDUs sent without holding the card, each one pays for its own exclusive access.
+    private(set) var perCommand = APDULatencyHistogram()
+    /// APDUs sent while the card was held.
+    private(set) var transaction = APDULatencyHistogram()
+    /// Beginning and ending a transaction, once per round.
+    private(set) var overhead = APDULatencyHistogram()
+    
+    init(apdusPerRound: Int) {
+        self.apdusPerRound = apdusPerRound
+    }
+    
+    mutating func record(_ duration: MeasurementNanoseconds, inTransaction: Bool) {
+        if inTransaction {
+            transaction.record(duration)
+        } else {
+            perCommand.record(duration)
+        }
+    }
+    
+    mutating func recordOverhead(_ duration: MeasurementNanoseconds) {
+        overhead.record(duration)
+    }
+    
+    mutating func completeRound() {
+        roundsCount += 1
+    }
+    
+    /// Nanoseconds an APDU saves by being sent in a transaction, the begin and end are spread over the APDUs of a round. Negative when holding the card costs more than it saves.
+    var savedPerAPDU: Int64 {
+        guard perCommand.count > 0, transaction.count > 0, apdusPerRound > 0 else { return 0 }
+        
+        let amortized = overhead.average / MeasurementNanoseconds(apdusPerRound)
+        return Int64(perCommand.average) - Int64(transaction.average + amortized)
+    }
+    
+    var description: String {
+        guard roundsCount > 0 else { return "No rounds run" }
+        
+        let saved = savedPerAPDU
+        let summary = saved >= 0 ? "saves \(UInt64(saved).preciseFormatted)" : "costs \(UInt64(-saved).preciseFormatted)"
+        
+        return "\(roundsCount) rounds of \(apdusPerRound) APDUs, per command \(perCommand), in a transaction \(transaction), begin/end \(overhead), a transaction \(summary) per APDU"
+    }
+}
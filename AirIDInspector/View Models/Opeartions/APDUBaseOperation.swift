@@ -13,9 +13,9 @@ class APDUBaseOperation: APDUOperationProtocol, Codable {
     let name: String
     
     /**
-     A Unique identifier only valid at the runtime for the operation, generally don't assume the id will be the same for operations among multiple picks.
+     A content addressed identifier, see `APDUOperationIdentity`.
      
-     Each subclass has it's own way of identifying itself.
+     It isn't unique within a script: repeated pairs, REPEAT expansions and every row sending the same APDU share it. Use the row index when a single row has to be identified.
      */
     let id: UUID
     
@@ -51,7 +51,7 @@ class APDUBaseOperation: APDUOperationProtocol, Codable {
     
     
     func setDevice(_ device: DeviceProtocol) { }
-
+    
     func start() async {
         do {
             try await self.tryStart()
@@ -72,15 +72,9 @@ class APDUBaseOperation: APDUOperationProtocol, Codable {
             self.state = state
         }
         
-        switch state {
-        case .pending:
-            print("Returning \(name) to Pending")
-        case .running:
-            print("Running \(name)")
-        case .failed(let operationError):
+        // logging every transition costs more than the APDU at high rates, only failures are worth it
+        if case .failed(let operationError) = state {
             print("\(name) has failed: \(operationError.localizedDescription)")
-        case .success:
-            print("\(name): Success")
         }
     }
     
@@ -104,6 +98,29 @@ class APDUBaseOperation: APDUOperationProtocol, Codable {
         self.type = try container.decode(APDUOperationType.self, forKey: .type)
     }
     
+    // MARK: - Binary Snapshot
+    
+    /**
+     Writes the fields of the operation to a binary snapshot, subclasses write their own fields before calling super.
+     
+     The type and the measurements are written by `APDUSnapshotFormat` itself.
+     */
+    func encode(to writer: inout APDUSnapshotWriter) {
+        writer.write(id)
+        writer.write(deviceID)
+        writer.write(name)
+        writer.write(state)
+    }
+    
+    init(type: APDUOperationType, from reader: inout APDUSnapshotReader) throws {
+        self.id = try reader.readUUID()
+        self.deviceID = try reader.readUUID()
+        self.name = try reader.readString()
+        self.measurements = .init(operationID: id)
+        self.state = try reader.readState()
+        self.type = type
+    }
+    
     enum CodingKeys: String, CodingKey {
         case id
         case type
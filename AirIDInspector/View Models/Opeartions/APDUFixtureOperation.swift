@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUFixtureOperation.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/// One end of the setup block of a script.
+enum APDUFixtureBoundary: UInt8, CaseIterable, Codable {
+    case begin
+    case end
+    
+    var name: String {
+        switch self {
+        case .begin: return "Begin Setup.."
+        case .end: return "End Setup.."
+        }
+    }
+}
+
+/**
+ Marks the rows setting the card up, see `APDUOperationTable.fixtureRows`. It doesn't send anything, the run decides whether the rows it encloses are sent.
+ */
+class APDUFixtureOperation: APDUBaseOperation {
+    private(set) var boundary: APDUFixtureBoundary
+    
+    init(id: UUID = UUID(), device: DeviceProtocol, boundary: APDUFixtureBoundary) {
+        self.boundary = boundary
+        super.init(id: id, type: .fixture, deviceID: device.id, name: boundary.name)
+    }
+    
+    required init(from decoder: Decoder) throws {
+        let container = try decoder.container(keyedBy: CodingKeys.self)
+        self.boundary = try container.decode(APDUFixtureBoundary.self, forKey: .boundary)
+        try super.init(from: decoder)
+    }
+    
+    override func encode(to encoder: Encoder) throws {
+        try super.encode(to: encoder)
+        var container = encoder.container(keyedBy: CodingKeys.self)
+        try container.encode(boundary, forKey: .boundary)
+    }
+    
+    override func encode(to writer: inout APDUSnapshotWriter) {
+        writer.write(boundary.rawValue)
+        super.encode(to: &writer)
+    }
+    
+    init(from reader: inout APDUSnapshotReader) throws {
+        let code = try reader.read(UInt8.self)
+        guard let boundary = APDUFixtureBoundary(rawValue: code) else {
+            throw APDUSnapshotFormat.CorruptedSnapshotError(reason: "unknown setup boundary \(code)")
+        }
+        
+        self.boundary = boundary
+        try super.init(type: .fixture, from: &reader)
+    }
+    
+    override func tryStart() async throws {
+        try Task.checkCancellation()
+        await self.state(to: .running)
+    }
+    
+    enum CodingKeys: String, CodingKey {
+        case boundary
+    }
+}
@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUInterningTable.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Shares the payloads of identical APDUs across the operations of a script.
+ 
+ Scripts repeat the same commands and expectations many times, operations created through the same table reference a single copy of every command, its hex name and every compiled matcher, so memory grows with the unique APDUs instead of the operations count. The table also follows the header of the script to derive the content addressed ids of the operations. Tables are safe to use from the concurrent parsing tasks.
+ */
+final class APDUInterningTable {
+    struct Report: CustomStringConvertible {
+        let operationsCount: Int
+        let uniqueCommandsCount: Int
+        let uniqueResponsesCount: Int
+        
+        /// Operations per unique command, 1 means nothing was shared.
+        var commandsRatio: Double {
+            uniqueCommandsCount == 0 ? 1 : Double(operationsCount) / Double(uniqueCommandsCount)
+        }
+        
+        var responsesRatio: Double {
+            uniqueResponsesCount == 0 ? 1 : Double(operationsCount) / Double(uniqueResponsesCount)
+        }
+        
+        var description: String {
+            String(format: "%d operations, %d unique commands (%.1fx), %d unique responses (%.1fx)",
+                   operationsCount, uniqueCommandsCount, commandsRatio, uniqueResponsesCount, responsesRatio)
+        }
+    }
+    
+    private struct MatcherKey: Hashable {
+        let expectedResponse: String
+        let options: Int
+    }
+    
+    private struct TestKey: Hashable {
+        let command: Data
+        let expectedResponse: String
+    }
+    
+    private let lock = NSLock()
+    private var commands: [Data: (data: Data, name: String)] = [:]
+    private var matchers: [MatcherKey: APDUResponseMatcher] = [:]
+    private var operationsCount = 0
+    
+    private var context = APDUOperationIdentity.Context()
+    /// Ids of the tests under the current context.
+    private var identifiers: [TestKey: UUID] = [:]
+    
+    /// Returns the shared copy of `data` and its hex name.
+    func command(_ data: Data) -> (data: Data, name: String) {
+        lock.lock()
+        defer { lock.unlock() }
+        
+        operationsCount += 1
+        
+        if let command = commands[data] {
+            return command
+        }
+        
+        let command = (data: data, name: data.hexEncodedString())
+        commands[data] = command
+        return command
+    }
+    
+    /// Returns the matcher compiled for `expectedResponse`, compiling it only the first time unless `compiled` is given.
+    func matcher(for expectedResponse: String, options: APDUTestOperation.Options, compiled: APDUResponseMatcher? = nil) -> APDUResponseMatcher {
+        let key = MatcherKey(expectedResponse: expectedResponse, options: options.rawValue)
+        
+        lock.lock()
+        defer { lock.unlock() }
+        
+        if let matcher = matchers[key] {
+            return matcher
+        }
+        
+        let matcher = compiled ?? APDUResponseMatcher(expectedResponse: expectedResponse, options: options)
+        matchers[key] = matcher
+        return matcher
+    }
+    
+    /// Makes `entry` the header in effect for the following identifiers, other entries are ignored.
+    func apply(_ entry: APDUScriptEntry) {
+        lock.lock()
+        defer { lock.unlock() }
+        
+        applyLocked(entry)
+    }
+    
+    /// The content addressed id of `entry` under the header applied so far, a header entry is applied too.
+    func identifier(for entry: APDUScriptEntry) -> UUID {
+        lock.lock()
+        defer { lock.unlock() }
+        
+        guard case .test(let command, let expectedResponse) = entry else {
+            let identifier = APDUOperationIdentity.identifier(for: entry, in: context)
+            applyLocked(entry)
+            return identifier
+        }
+        
+        let key = TestKey(command: command, expectedResponse: expectedResponse)
+        if let identifier = identifiers[key] {
+            return identifier
+        }
+        
+        let identifier = APDUOperationIdentity.identifier(for: entry, in: context)
+        identifiers[key] = identifier
+        return identifier
+    }
+    
+    private func applyLocked(_ entry: APDUScriptEntry) {
+        var context = self.context
+        context.apply(entry)
+        
+        if context != self.context {
+            self.context = context
+            identifiers.removeAll()
+        }
+    }
+    
+    var report: Report {
+        lock.lock()
+        defer { lock.unlock() }
+        
+        return Report(operationsCount: operationsCount,
+                      uniqueCommandsCount: commands.count,
+                      uniqueResponsesCount: matchers.count)
+    }
+}
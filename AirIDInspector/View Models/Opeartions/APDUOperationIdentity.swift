@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUOperationIdentity.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+import CryptoKit
+import AirIDDriver
+
+/**
+ Content addressed ids of operations.
+ 
+ The id of an operation only depends on what it sends and expects, and on the header in effect (protocol and ATR), never on its position in a script or on the device running it. The same APDU gets the same id in every script, launch and device, so its measurements can be combined and kept in `APDUMeasurementHistory`.
+ */
+enum APDUOperationIdentity {
+    /// The header in effect for the tests following it.
+    struct Context: Equatable {
+        var cardProtocol: AIPCardProtocol?
+        var atrData: Data?
+        
+        /// Header entries change the context of the entries following them.
+        mutating func apply(_ entry: APDUScriptEntry) {
+            switch entry {
+            case .selectATR(let atrData):
+                self.atrData = atrData
+            case .setProtocol(let cardProtocol):
+                self.cardProtocol = cardProtocol
+            case .test, .transaction, .fixture:
+                break
+            }
+        }
+    }
+    
+    static func identifier(for entry: APDUScriptEntry, in context: Context) -> UUID {
+        var writer = APDUSnapshotWriter()
+        writer.write(entry.type.tag)
+        
+        switch entry {
+        case .selectATR(let atrData):
+            writer.write(atrData)
+        case .setProtocol(let cardProtocol):
+            writer.write(UInt64(cardProtocol.rawValue))
+            writer.write(context.atrData)
+        case .transaction(let boundary):
+            writer.write(boundary.code)
+        case .fixture(let boundary):
+            writer.write(boundary.rawValue)
+        case .test(let command, let expectedResponse):
+            writer.write(command)
+            writer.write(expectedResponse)
+            writer.write(UInt64(context.cardProtocol?.rawValue ?? 0))
+            writer.write(context.atrData)
+        }
+        
+        return uuid(from: SHA256.hash(data: writer.data))
+    }
+    
+    /// A name based UUID (version 5 layout) from the first bytes of `digest`.
+    private static func uuid(from digest: SHA256.Digest) -> UUID {
+        var bytes = Array(digest.prefix(16))
+        bytes[6] = (bytes[6] & 0x0F) | 0x50
+        bytes[8] = (bytes[8] & 0x3F) | 0x80
+        
+        return bytes.withUnsafeBytes { UUID(uuid: $0.loadUnaligned(as: uuid_t.self)) }
+    }
+}
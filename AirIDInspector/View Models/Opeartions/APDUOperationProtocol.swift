@@ -59,6 +59,7 @@ enum OperationState: Codable {
 }
 
 
+/// `id` is the content addressed id of the operation, operations running the same APDU are identified the same.
 protocol APDUOperationProtocol: ObservableObject, Identifiable {
     
     var statePublisher: Published<OperationState>.Publisher { get }
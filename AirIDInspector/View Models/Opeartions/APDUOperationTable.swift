@@ -0,0 +1,691 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUOperationTable.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+import Combine
+import AirIDDriver
+
+/**
+ The operations of a test held column by column instead of one `APDUBaseOperation` per operation.
+ 
+ Every row is a handful of integers in contiguous arrays: a type, ids into the pools of unique commands and compiled matchers, a state code and aggregated stats. Durations are appended to a single log shared by all rows. `Row` values are only created for what is displayed, and `APDUBaseOperation`s are only materialized to save or export a test.
+ 
+ The table can be built anywhere, once published it has to be mutated from the main actor.
+ */
+final class APDUOperationTable: ObservableObject {
+    enum StateCode: UInt8 {
+        case pending
+        case running
+        case success
+        case failed
+    }
+    
+    /// A lightweight view of a single row, for display.
+    struct Row: Identifiable {
+        let id: Int
+        /// The content addressed id, shared by the rows running the same APDU.
+        let identity: UUID
+        let type: APDUOperationType
+        let name: String
+        let state: OperationState
+        let description: String
+    }
+    
+    /// A change of a single row, for consumers which need every change rather than what is displayed.
+    enum RowEvent {
+        case state(row: Int, StateCode)
+        case measured(row: Int, MeasurementNanoseconds)
+    }
+    
+    private static let none = UInt32.max
+    
+    // MARK: Pools
+    
+    private var commandBytes: [UInt8] = []
+    /// Unique command `i` is `commandBytes[commandOffsets[i]..<commandOffsets[i + 1]]`
+    private var commandOffsets: [Int] = [0]
+    private var commandNames: [String] = []
+    private var commandIDs: [Data: UInt32] = [:]
+    
+    private struct MatcherKey: Hashable {
+        let expectedResponse: String
+        let options: Int
+    }
+    
+    private var matchers: [APDUResponseMatcher] = []
+    private var matcherIDs: [MatcherKey: UInt32] = [:]
+    
+    // MARK: Columns
+    
+    /// Content addressed ids, see `APDUOperationIdentity`.
+    private var identifiers: [UUID] = []
+    private var types: [UInt8] = []
+    private var rowCommands: [UInt32] = []
+    private var rowMatchers: [UInt32] = []
+    private var states: [UInt8] = []
+    private var runsCounts: [UInt32] = []
+    private var totals: [MeasurementNanoseconds] = []
+    private var minimums: [MeasurementNanoseconds] = []
+    private var maximums: [MeasurementNanoseconds] = []
+    
+    /// Durations of all rows in the order they were measured.
+    private var durationRows: [UInt32] = []
+    private var durationValues: [MeasurementNanoseconds] = []
+    
+    // sparse, only header, transaction, setup and failed rows have these
+    private var atrs: [Int: Data] = [:]
+    private var responseATRs: [Int: Data] = [:]
+    private var cardProtocols: [Int: AIPCardProtocol] = [:]
+    private var transactionBoundaries: [Int: APDUTransactionBoundary] = [:]
+    private var fixtureBoundaries: [Int: APDUFixtureBoundary] = [:]
+    private var failures: [Int: OperationError] = [:]
+    
+    private var identityContext = APDUOperationIdentity.Context()
+    /// Ids of the tests under `identityContext`, by command and matcher id.
+    private var testIdentifiers: [UInt64: UUID] = [:]
+    
+    /// Every state change and measurement as it happens, sent from where the row is written.
+    let events = PassthroughSubject<RowEvent, Never>()
+    
+    /// Views are refreshed at most once per display refresh, however many rows change in between.
+    private lazy var changes = APDUChangeCoalescer { [weak self] in
+        self?.objectWillChange.send()
+    }
+    
+    lazy var benchTimer: APDUBenchTimerProtocol = {
+        if #available(iOS 16.0, *) {
+            return APDUClockBenchTimer()
+        } else {
+            return APDULegacyBenchTimer()
+        }
+    }()
+    
+    init() { }
+    
+    convenience init<Entries: Sequence>(entries: Entries) where Entries.Element == APDUScriptEntry {
+        self.init()
+        entries.forEach { append($0) }
+    }
+    
+    /// Imports already created operations, with their states and measurements.
+    convenience init(operations: [APDUBaseOperation]) {
+        self.init()
+        reserveCapacity(operations.count)
+        operations.forEach { append($0) }
+    }
+    
+    /// Imports an already created operation, with its state and measurements.
+    func append(_ operation: APDUBaseOperation) {
+        let row = count
+        
+        switch operation {
+        case let operation as APDUTestOperation:
+            append(.test(command: operation.data, expectedResponse: operation.expectedResponse), options: operation.options, matcher: operation.matcher)
+        case let operation as APDUSelectATROperation:
+            append(.selectATR(operation.atrData))
+            responseATRs[row] = operation.responseATR
+        case let operation as APDUSetProtocolOperation:
+            append(.setProtocol(operation.cardProtocol))
+        case let operation as APDUTransactionOperation:
+            append(.transaction(operation.boundary))
+        case let operation as APDUFixtureOperation:
+            append(.fixture(operation.boundary))
+        default:
+            return
+        }
+        
+        operation.measurements.durations.forEach { record(duration: $0, at: row) }
+        setState(operation.state, at: row)
+    }
+    
+    var count: Int {
+        types.count
+    }
+    
+    var indices: Range<Int> {
+        0..<count
+    }
+    
+    func reserveCapacity(_ capacity: Int) {
+        identifiers.reserveCapacity(capacity)
+        types.reserveCapacity(capacity)
+        rowCommands.reserveCapacity(capacity)
+        rowMatchers.reserveCapacity(capacity)
+        states.reserveCapacity(capacity)
+        runsCounts.reserveCapacity(capacity)
+        totals.reserveCapacity(capacity)
+        minimums.reserveCapacity(capacity)
+        maximums.reserveCapacity(capacity)
+    }
+    
+    /// - parameter matcher: the expected response of a test already compiled with `options`, e.g. read from a compiled script.
+    func append(_ entry: APDUScriptEntry, options: APDUTestOperation.Options = .defaultOptions, matcher compiledMatcher: APDUResponseMatcher? = nil) {
+        let row = count
+        var command = Self.none
+        var matcher = Self.none
+        
+        let identifier: UUID
+        
+        switch entry {
+        case .selectATR(let atrData):
+            atrs[row] = atrData
+            identifier = headerIdentifier(for: entry)
+        case .setProtocol(let cardProtocol):
+            cardProtocols[row] = cardProtocol
+            identifier = headerIdentifier(for: entry)
+        case .transaction(let boundary):
+            transactionBoundaries[row] = boundary
+            identifier = APDUOperationIdentity.identifier(for: entry, in: identityContext)
+        case .fixture(let boundary):
+            fixtureBoundaries[row] = boundary
+            identifier = APDUOperationIdentity.identifier(for: entry, in: identityContext)
+        case .test(let data, let expectedResponse):
+            command = commandID(for: data)
+            matcher = matcherID(for: expectedResponse, options: options, compiled: compiledMatcher)
+            identifier = testIdentifier(for: entry, key: UInt64(command) << 32 | UInt64(matcher))
+        }
+        
+        identifiers.append(identifier)
+        types.append(entry.type.tag)
+        rowCommands.append(command)
+        rowMatchers.append(matcher)
+        states.append(StateCode.pending.rawValue)
+        runsCounts.append(0)
+        totals.append(0)
+        minimums.append(.max)
+        maximums.append(0)
+    }
+    
+    private func headerIdentifier(for entry: APDUScriptEntry) -> UUID {
+        let identifier = APDUOperationIdentity.identifier(for: entry, in: identityContext)
+        
+        let context = identityContext
+        identityContext.apply(entry)
+        if identityContext != context {
+            testIdentifiers.removeAll()
+        }
+        
+        return identifier
+    }
+    
+    private func testIdentifier(for entry: APDUScriptEntry, key: UInt64) -> UUID {
+        if let identifier = testIdentifiers[key] {
+            return identifier
+        }
+        
+        let identifier = APDUOperationIdentity.identifier(for: entry, in: identityContext)
+        testIdentifiers[key] = identifier
+        return identifier
+    }
+    
+    private func commandID(for data: Data) -> UInt32 {
+        if let id = commandIDs[data] {
+            return id
+        }
+        
+        let id = UInt32(commandNames.count)
+        commandBytes.append(contentsOf: data)
+        commandOffsets.append(commandBytes.count)
+        commandNames.append(data.hexEncodedString())
+        commandIDs[data] = id
+        return id
+    }
+    
+    private func matcherID(for expectedResponse: String, options: APDUTestOperation.Options, compiled: APDUResponseMatcher?) -> UInt32 {
+        let key = MatcherKey(expectedResponse: expectedResponse, options: options.rawValue)
+        if let id = matcherIDs[key] {
+            return id
+        }
+        
+        let id = UInt32(matchers.count)
+        matchers.append(compiled ?? APDUResponseMatcher(expectedResponse: expectedResponse, options: options))
+        matcherIDs[key] = id
+        return id
+    }
+    
+    // MARK: - Reading
+    
+    func identifier(at row: Int) -> UUID {
+        identifiers[row]
+    }
+    
+    func type(at row: Int) -> APDUOperationType {
+        APDUOperationType(tag: types[row])!
+    }
+    
+    func command(at row: Int) -> Data? {
+        let id = rowCommands[row]
+        guard id != Self.none else { return nil }
+        
+        return Data(commandBytes[commandOffsets[Int(id)]..<commandOffsets[Int(id) + 1]])
+    }
+    
+    func matcher(at row: Int) -> APDUResponseMatcher? {
+        let id = rowMatchers[row]
+        return id == Self.none ? nil : matchers[Int(id)]
+    }
+    
+    /// The ATR a select ATR row expects, nil for any card.
+    func expectedATR(at row: Int) -> Data? {
+        atrs[row]
+    }
+    
+    /// The ATR the card answered the last time a select ATR row ran.
+    func responseATR(at row: Int) -> Data? {
+        responseATRs[row]
+    }
+    
+    func cardProtocol(at row: Int) -> AIPCardProtocol? {
+        cardProtocols[row]
+    }
+    
+    func transactionBoundary(at row: Int) -> APDUTransactionBoundary? {
+        transactionBoundaries[row]
+    }
+    
+    /// The transaction rows within `rows`, in order.
+    func transactionRows(in rows: Range<Int>) -> [Int] {
+        transactionBoundaries.keys.filter(rows.contains).sorted()
+    }
+    
+    func fixtureBoundary(at row: Int) -> APDUFixtureBoundary? {
+        fixtureBoundaries[row]
+    }
+    
+    /// The setup block right after the header rows, both its boundaries included. Nil without one, a setup block anywhere else is run like the other rows.
+    var fixtureRows: Range<Int>? {
+        let begin = leadingHeaderRows.upperBound
+        guard fixtureBoundaries[begin] == .begin,
+              let end = fixtureBoundaries.first(where: { $0.key > begin && $0.value == .end })?.key else { return nil }
+        
+        return begin..<end + 1
+    }
+    
+    /// The header rows the table starts with, setting the card up for the APDUs. A transaction ends them, it holds the card for the rows following it.
+    var leadingHeaderRows: Range<Int> {
+        0..<(types.firstIndex { !APDUOperationType(tag: $0)!.isHeader } ?? count)
+    }
+    
+    func name(at row: Int) -> String {
+        switch type(at: row) {
+        case .apduTest:
+            return commandNames[Int(rowCommands[row])]
+        case .selectATR:
+            return atrs[row] == nil ? "Selecting ATR.." : "Select ATR.."
+        case .setProtocol:
+            return "Set Protocol.."
+        case .transaction:
+            return transactionBoundaries[row]?.name ?? ""
+        case .fixture:
+            return fixtureBoundaries[row]?.name ?? ""
+        }
+    }
+    
+    func state(at row: Int) -> OperationState {
+        switch StateCode(rawValue: states[row])! {
+        case .pending: return .pending
+        case .running: return .running
+        case .success: return .success
+        case .failed: return .failed(failures[row] ?? .explicit("Failed"))
+        }
+    }
+    
+    func stateCode(at row: Int) -> StateCode {
+        StateCode(rawValue: states[row])!
+    }
+    
+    func failure(at row: Int) -> OperationError? {
+        failures[row]
+    }
+    
+    /// Whether the row failed on what the card answered, rather than on the device or the run.
+    func isResponseMismatch(at row: Int) -> Bool {
+        guard case .invalidResponse = failures[row] else { return false }
+        return true
+    }
+    
+    /// Same summary as `APDUMeasurement.description`, from the aggregated stats.
+    func statsDescription(at row: Int) -> String {
+        let runs = runsCounts[row]
+        
+        if runs == 0 {
+            return "No Measurements yet"
+        }
+        
+        if runs == 1 {
+            return totals[row].humanFormatted
+        }
+        
+        let avg = totals[row] / UInt64(runs)
+        return "MIN: \(minimums[row].humanFormatted) AVG: \(avg.humanFormatted) MAX: \(maximums[row].humanFormatted)"
+    }
+    
+    func row(at index: Int) -> Row {
+        let description: String
+        switch type(at: index) {
+        case .apduTest:
+            description = statsDescription(at: index)
+        case .selectATR:
+            description = responseATRs[index]?.hexEncodedString() ?? ""
+        case .setProtocol:
+            description = "Protocol \(cardProtocols[index]?.description ?? "")"
+        case .transaction, .fixture:
+            description = ""
+        }
+        
+        return Row(id: index, identity: identifiers[index], type: type(at: index), name: name(at: index), state: state(at: index), description: description)
+    }
+    
+    /// Number of test rows and unique payloads, same measure as the sources' interning report.
+    var interningReport: APDUInterningTable.Report {
+        APDUInterningTable.Report(operationsCount: types.lazy.filter { $0 == APDUOperationType.apduTest.tag }.count,
+                                  uniqueCommandsCount: commandNames.count,
+                                  uniqueResponsesCount: matchers.count)
+    }
+    
+    /// The number of durations recorded so far, a mark for `measurements(since:)`.
+    var measurementsCount: Int {
+        durationValues.count
+    }
+    
+    /// Durations recorded after `mark` with the content addressed ids of their rows.
+    func measurements(since mark: Int) -> [(UUID, MeasurementNanoseconds)] {
+        zip(durationRows[mark...], durationValues[mark...]).map { (identifiers[Int($0)], $1) }
+    }
+    
+    /// The content addressed ids of all rows, without repetitions.
+    var uniqueIdentifiers: Set<UUID> {
+        Set(identifiers)
+    }
+    
+    /// The durations of every row, gathered from the log in one pass.
+    func durationsByRow() -> [[MeasurementNanoseconds]] {
+        var durations = Array(repeating: [MeasurementNanoseconds](), count: count)
+        for (row, duration) in zip(durationRows, durationValues) {
+            durations[Int(row)].append(duration)
+        }
+        
+        return durations
+    }
+    
+    // MARK: - Writing
+    
+    func setState(_ state: OperationState, at row: Int) {
+        switch state {
+        case .pending:
+            write(.pending, at: row)
+        case .running:
+            write(.running, at: row)
+        case .success:
+            write(.success, at: row)
+        case .failed(let error):
+            failures[row] = error
+            write(.failed, at: row)
+            return
+        }
+        
+        failures[row] = nil
+    }
+    
+    private func write(_ code: StateCode, at row: Int) {
+        states[row] = code.rawValue
+        events.send(.state(row: row, code))
+        changes.setNeedsPublish()
+    }
+    
+    func record(duration: MeasurementNanoseconds, at row: Int) {
+        runsCounts[row] += 1
+        totals[row] += duration
+        minimums[row] = min(minimums[row], duration)
+        maximums[row] = max(maximums[row], duration)
+        
+        durationRows.append(UInt32(row))
+        durationValues.append(duration)
+        events.send(.measured(row: row, duration))
+    }
+    
+    // MARK: - Materializing
+    
+    /// Creates a standalone operation of `row`, with its state and measurements.
+    func operation(at row: Int, for device: DeviceProtocol, durations: [MeasurementNanoseconds]? = nil) -> APDUBaseOperation {
+        let operation: APDUBaseOperation
+        
+        switch type(at: row) {
+        case .apduTest:
+            let matcher = self.matcher(at: row)!
+            operation = APDUTestOperation(id: identifiers[row], device: device, data: command(at: row)!, expectedResponse: matcher.expectedResponse, options: matcher.options)
+        case .selectATR:
+            operation = APDUSelectATROperation(id: identifiers[row], device: device, name: name(at: row), atrData: atrs[row], responseATR: responseATRs[row])
+        case .setProtocol:
+            operation = APDUSetProtocolOperation(id: identifiers[row], device: device, name: name(at: row), protocol: cardProtocols[row] ?? .T1)
+        case .transaction:
+            operation = APDUTransactionOperation(id: identifiers[row], device: device, boundary: transactionBoundaries[row] ?? .begin)
+        case .fixture:
+            operation = APDUFixtureOperation(id: identifiers[row], device: device, boundary: fixtureBoundaries[row] ?? .begin)
+        }
+        
+        operation.measurements = APDUMeasurement(operationID: operation.id, durations: durations ?? durationsByRow()[row])
+        operation.state = state(at: row)
+        return operation
+    }
+    
+    /// Materializes every row, to save or export the test.
+    func operations(for device: DeviceProtocol) -> [APDUBaseOperation] {
+        let durations = durationsByRow()
+        return indices.map { operation(at: $0, for: device, durations: durations[$0]) }
+    }
+    
+    // MARK: - Reloading
+    
+    /**
+     Carries the state and measurements of the rows of `previous` which are left unchanged in this table, returns how many rows were carried.
+     
+     Both tables are diffed row by row, i.e. per request/response pair, the difference grows with the edit rather than the script so reloading a large script after editing a few lines stays cheap. Call it before the table is published.
+     */
+    @discardableResult
+    func inheritUnchangedRows(of previous: APDUOperationTable) -> Int {
+        // rows with the same content addressed id run the same APDU
+        let difference = identifiers.difference(from: previous.identifiers)
+        
+        var removed = IndexSet()
+        var inserted = IndexSet()
+        for change in difference {
+            switch change {
+            case .remove(let offset, _, _):
+                removed.insert(offset)
+            case .insert(let offset, _, _):
+                inserted.insert(offset)
+            }
+        }
+        
+        // what isn't removed from the previous rows nor inserted in the new ones pairs up in order
+        let kept = zip(IndexSet(previous.indices).subtracting(removed), IndexSet(indices).subtracting(inserted))
+        let durations = previous.durationsByRow()
+        var count = 0
+        
+        for (previousRow, row) in kept {
+            states[row] = previous.states[previousRow]
+            failures[row] = previous.failures[previousRow]
+            responseATRs[row] = previous.responseATRs[previousRow]
+            durations[previousRow].forEach { record(duration: $0, at: row) }
+            count += 1
+        }
+        
+        return count
+    }
+    
+    // MARK: - Replicating
+    
+    /// The same rows with pending states and no measurements, for running the test on another device. The pools and columns are shared until either table writes to them.
+    func replica() -> APDUOperationTable {
+        let replica = APDUOperationTable()
+        replica.commandBytes = commandBytes
+        replica.commandOffsets = commandOffsets
+        replica.commandNames = commandNames
+        replica.commandIDs = commandIDs
+        replica.matchers = matchers
+        replica.matcherIDs = matcherIDs
+        replica.identifiers = identifiers
+        replica.types = types
+        replica.rowCommands = rowCommands
+        replica.rowMatchers = rowMatchers
+        replica.atrs = atrs
+        replica.cardProtocols = cardProtocols
+        replica.transactionBoundaries = transactionBoundaries
+        replica.fixtureBoundaries = fixtureBoundaries
+        replica.identityContext = identityContext
+        replica.testIdentifiers = testIdentifiers
+        
+        replica.states = Array(repeating: StateCode.pending.rawValue, count: count)
+        replica.runsCounts = Array(repeating: 0, count: count)
+        replica.totals = Array(repeating: 0, count: count)
+        replica.minimums = Array(repeating: .max, count: count)
+        replica.maximums = Array(repeating: 0, count: count)
+        return replica
+    }
+    
+    // MARK: - Running
+    
+    /**
+     Runs a single row on `device`, returns false if the run should stop.
+     
+     APDU rows are sent straight from the table, the few header and transaction rows go through a transient operation. Exchanges are timed into `report`.
+     */
+    @MainActor
+    func run(_ row: Int, on device: DeviceProtocol, report: inout APDURunReport) async -> Bool {
+        setState(.running, at: row)
+        
+        do {
+            try Task.checkCancellation()
+            
+            if type(at: row) == .apduTest {
+                try await runAPDU(row, on: device, report: &report)
+            } else {
+                let operation = self.operation(at: row, for: device, durations: [])
+                let startedAt = DispatchTime.now().uptimeNanoseconds
+                try await operation.tryStart()
+                
+                // only a reset powers the card up, protocol, transaction and setup rows aren't part of it
+                if let operation = operation as? APDUSelectATROperation {
+                    report.recordPowerCycling(from: startedAt, to: DispatchTime.now().uptimeNanoseconds)
+                    
+                    if let responseATR = operation.responseATR {
+                        responseATRs[row] = responseATR
+                    }
+                } else {
+                    report.breakGap()
+                }
+            }
+            
+            setState(.success, at: row)
+            return true
+        } catch is CancellationError {
+            setState(.failed(.cancelled), at: row)
+            return false
+        } catch let error as OperationError {
+            setState(.failed(error), at: row)
+            return false
+        } catch {
+            setState(.failed(.explicit(error.localizedDescription)), at: row)
+            return false
+        }
+    }
+    
+    @MainActor
+    private func runAPDU(_ row: Int, on device: DeviceProtocol, report: inout APDURunReport) async throws {
+        let command = self.command(at: row)!
+        let matcher = self.matcher(at: row)!
+        
+        var exchange: APDUExchange?
+        let sentAt = DispatchTime.now().uptimeNanoseconds
+        let duration = try await benchTimer.measure {
+            exchange = try await device.exchangeAPDU(with: command)
+        }
+        
+        // the duration of a chained APDU covers all of its round trips
+        record(duration: duration, at: row)
+        report.record(sentAt: sentAt, receivedAt: sentAt + duration, roundTripsCount: exchange?.roundTripsCount ?? 1)
+        
+        if let failure = matcher.failure(for: exchange?.response ?? Data()) {
+            throw failure
+        }
+    }
+    
+    // MARK: - Pipelining
+    
+    /// What the pipelined runner needs to send and validate a row.
+    struct PreparedRow {
+        let row: Int
+        let command: Data
+        let matcher: APDUResponseMatcher
+    }
+    
+    /// The outcome of a row run away from the table.
+    struct RowOutcome {
+        let row: Int
+        let duration: MeasurementNanoseconds?
+        let error: OperationError?
+    }
+    
+    /// Prepares the APDU rows of `rows` and marks them running, stops at the first row which isn't an APDU.
+    @MainActor
+    func prepare(_ rows: Range<Int>) -> [PreparedRow] {
+        var prepared: [PreparedRow] = []
+        prepared.reserveCapacity(rows.count)
+        
+        for row in rows {
+            guard let command = command(at: row), let matcher = matcher(at: row) else { break }
+            prepared.append(PreparedRow(row: row, command: command, matcher: matcher))
+            write(.running, at: row)
+        }
+        
+        return prepared
+    }
+    
+    /// Writes the outcomes of many rows in one main actor hop.
+    @MainActor
+    func apply(_ outcomes: [RowOutcome]) {
+        for outcome in outcomes {
+            if let duration = outcome.duration {
+                record(duration: duration, at: outcome.row)
+            }
+            
+            failures[outcome.row] = outcome.error
+            write(outcome.error == nil ? .success : .failed, at: outcome.row)
+        }
+    }
+    
+    /// Returns rows left running by an interrupted run to pending.
+    @MainActor
+    func resetRunningRows(in rows: Range<Int>) {
+        for row in rows where states[row] == StateCode.running.rawValue {
+            write(.pending, at: row)
+        }
+    }
+    
+    /// Returns rows to pending so they can run again, the durations they already measured are kept.
+    @MainActor
+    func resetRows(in rows: Range<Int>) {
+        for row in rows {
+            failures[row] = nil
+            write(.pending, at: row)
+        }
+    }
+}
+
+extension APDUScriptEntry {
+    var type: APDUOperationType {
+        switch self {
+        case .selectATR: return .selectATR
+        case .setProtocol: return .setProtocol
+        case .test: return .apduTest
+        case .transaction: return .transaction
+        case .fixture: return .fixture
+        }
+    }
+}
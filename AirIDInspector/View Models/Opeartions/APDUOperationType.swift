@@ -12,6 +12,13 @@ enum APDUOperationType: String, Codable {
     case apduTest
     case setProtocol
     case selectATR
+    case transaction
+    case fixture
+    
+    /// Whether operations of the type set the card up, rather than run against it.
+    var isHeader: Bool {
+        self == .selectATR || self == .setProtocol
+    }
 }
 
 /**
@@ -48,6 +55,10 @@ struct APDUOperationContainer: Codable {
             self.internalOperation = try APDUSetProtocolOperation(from: decoder)
         case .selectATR:
             self.internalOperation = try APDUSelectATROperation(from: decoder)
+        case .transaction:
+            self.internalOperation = try APDUTransactionOperation(from: decoder)
+        case .fixture:
+            self.internalOperation = try APDUFixtureOperation(from: decoder)
         }
     }
     
@@ -0,0 +1,308 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUResponseMatcher.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ An expected response compiled once, when the operation is created.
+ 
+ Expected responses are regular expressions evaluated against the uppercase hex of the response. Patterns made only of uppercase hex digits and `.`, optionally anchored with `^` and `$` (exact bytes, `9000`, `6...`, prefixes and suffixes), are compiled into byte masks and compared directly on the response bytes, without encoding it or allocating. Anything else goes through a cached `NSRegularExpression`.
+ */
+struct APDUResponseMatcher {
+    /// Raw values are stored in compiled scripts.
+    enum Kind: UInt8, Equatable {
+        case nibbles = 0
+        case regex = 1
+        case bytes = 2
+        case statusWord = 3
+    }
+    
+    let expectedResponse: String
+    let options: APDUTestOperation.Options
+    let kind: Kind
+    
+    private let pattern: NibblePattern?
+    private let expression: NSRegularExpression?
+    
+    init(expectedResponse: String, options: APDUTestOperation.Options = .defaultOptions) {
+        self.expectedResponse = expectedResponse
+        self.options = options
+        
+        if options.contains(.evaluateRegex) {
+            self.pattern = NibblePattern(regex: expectedResponse)
+            self.kind = pattern == nil ? .regex : .nibbles
+            self.expression = pattern == nil ? Self.cachedExpression(expectedResponse) : nil
+        } else {
+            // without regex evaluation the response is hex, only SW1SW2 means the data is ignored
+            let bytes = expectedResponse.hexadecimal ?? Data()
+            self.pattern = bytes.isEmpty ? nil : NibblePattern(bytes: bytes, anchoredAtStart: bytes.count != 2)
+            self.kind = bytes.count == 2 ? .statusWord : .bytes
+            self.expression = nil
+        }
+    }
+    
+    private init(expectedResponse: String, options: APDUTestOperation.Options, kind: Kind, pattern: NibblePattern?) {
+        self.expectedResponse = expectedResponse
+        self.options = options
+        self.kind = kind
+        self.pattern = pattern
+        self.expression = kind == .regex ? Self.cachedExpression(expectedResponse) : nil
+    }
+    
+    /// The bytes the expected response stands for, reported when validation fails.
+    var expectedData: Data {
+        expectedResponse.hexadecimal ?? Data()
+    }
+    
+    func matches(_ response: Data) -> Bool {
+        if let pattern = pattern {
+            return response.withUnsafeBytes { pattern.matches($0) }
+        }
+        
+        guard let expression = expression else { return false }
+        
+        let string = response.hexEncodedString()
+        return expression.firstMatch(in: string, range: NSRange(location: 0, length: string.utf16.count)) != nil
+    }
+    
+    /**
+     The error reporting that `response` didn't match, nil when it did.
+     
+     Hex responses compared as bytes report the whole response, patterns and status words only SW1SW2.
+     */
+    func failure(for response: Data) -> OperationError? {
+        guard !matches(response) else { return nil }
+        
+        switch kind {
+        case .bytes:
+            guard !expectedData.isEmpty else {
+                return .serializationError("Expected Response isn't hex format")
+            }
+            
+            return .invalidResponse(response, expectedData)
+        case .nibbles, .regex, .statusWord:
+            return .invalidResponse(response.suffix(2), expectedData)
+        }
+    }
+    
+    // MARK: - Compiled Form
+    
+    /**
+     Appends what the matcher was compiled into, for `APDUScriptCompiler`: `kind: UInt8`, then for every kind but `.regex` `anchors: UInt8 | nibbleCount: varint | masks`.
+     
+     A regex is only compiled from the expected response stored next to it, `nibbleCount` is 0 for a hex response which isn't hex.
+     */
+    func write(to data: inout Data) {
+        data.append(kind.rawValue)
+        guard kind != .regex else { return }
+        
+        if let pattern = pattern {
+            pattern.write(to: &data)
+        } else {
+            data.append(0)
+            data.appendVarint(0)
+        }
+    }
+    
+    /// Reads a matcher written by `write(to:)` at `position` and moves past it, the expected response isn't analysed again.
+    init(compiled raw: UnsafeRawBufferPointer, at position: inout Int, limit: Int, expectedResponse: String, options: APDUTestOperation.Options) throws {
+        guard position < limit, let kind = Kind(rawValue: raw[position]) else {
+            throw APDUCompiledScriptFormat.CorruptedFileError(reason: "invalid matcher at \(position)")
+        }
+        
+        position += 1
+        let pattern = try kind == .regex ? nil : NibblePattern(compiled: raw, at: &position, limit: limit)
+        
+        self.init(expectedResponse: expectedResponse, options: options, kind: kind, pattern: pattern)
+    }
+    
+    /// Moves past a matcher written by `write(to:)` without building it.
+    static func skipCompiled(_ raw: UnsafeRawBufferPointer, at position: inout Int, limit: Int) throws {
+        guard position < limit, let kind = Kind(rawValue: raw[position]) else {
+            throw APDUCompiledScriptFormat.CorruptedFileError(reason: "invalid matcher at \(position)")
+        }
+        
+        position += 1
+        if kind != .regex {
+            _ = try NibblePattern.compiled(raw, at: &position, limit: limit)
+        }
+    }
+    
+    // MARK: - Regex Fallback
+    
+    private static let expressions = NSCache<NSString, NSRegularExpression>()
+    
+    /// A pattern which isn't a valid regular expression never matches, as before.
+    private static func cachedExpression(_ pattern: String) -> NSRegularExpression? {
+        if let expression = expressions.object(forKey: pattern as NSString) {
+            return expression
+        }
+        
+        guard let expression = try? NSRegularExpression(pattern: pattern) else { return nil }
+        expressions.setObject(expression, forKey: pattern as NSString)
+        return expression
+    }
+}
+
+extension APDUResponseMatcher {
+    /**
+     A sequence of hex digits and wildcards, searched nibble by nibble in the response.
+     
+     The pattern is kept twice as byte masks, once starting on a byte boundary and once starting on the second nibble of a byte, so every candidate position is a plain masked byte comparison.
+     */
+    struct NibblePattern {
+        let nibbleCount: Int
+        let anchoredAtStart: Bool
+        let anchoredAtEnd: Bool
+        
+        /// `[aligned values, aligned masks, shifted values, shifted masks]`, each `alignedCount` and `shiftedCount` long.
+        private let storage: [UInt8]
+        private let alignedCount: Int
+        private let shiftedCount: Int
+        
+        init?(regex: String) {
+            var utf8 = Substring(regex).utf8
+            let anchoredAtStart = utf8.first == UInt8(ascii: "^")
+            if anchoredAtStart { utf8.removeFirst() }
+            let anchoredAtEnd = utf8.last == UInt8(ascii: "$")
+            if anchoredAtEnd { utf8.removeLast() }
+            
+            var nibbles: [UInt8?] = []
+            nibbles.reserveCapacity(utf8.count)
+            
+            for character in utf8 {
+                switch character {
+                case UInt8(ascii: "0")...UInt8(ascii: "9"):
+                    nibbles.append(character - UInt8(ascii: "0"))
+                case UInt8(ascii: "A")...UInt8(ascii: "F"):
+                    nibbles.append(character - UInt8(ascii: "A") + 10)
+                case UInt8(ascii: "."):
+                    nibbles.append(nil)
+                default:
+                    // lowercase digits never matched the uppercase hex, leave those to the regex as well
+                    return nil
+                }
+            }
+            
+            guard !nibbles.isEmpty else { return nil }
+            self.init(nibbles: nibbles, anchoredAtStart: anchoredAtStart, anchoredAtEnd: anchoredAtEnd)
+        }
+        
+        init(bytes: Data, anchoredAtStart: Bool) {
+            let nibbles = bytes.flatMap { [Optional($0 >> 4), Optional($0 & 0x0F)] }
+            self.init(nibbles: nibbles, anchoredAtStart: anchoredAtStart, anchoredAtEnd: true)
+        }
+        
+        private init(nibbleCount: Int, anchoredAtStart: Bool, anchoredAtEnd: Bool, storage: [UInt8]) {
+            self.nibbleCount = nibbleCount
+            self.anchoredAtStart = anchoredAtStart
+            self.anchoredAtEnd = anchoredAtEnd
+            self.alignedCount = (nibbleCount + 1) / 2
+            self.shiftedCount = (nibbleCount + 2) / 2
+            self.storage = storage
+        }
+        
+        /// `anchors: UInt8 | nibbleCount: varint | storage`, the storage length follows from the nibbles count.
+        func write(to data: inout Data) {
+            data.append((anchoredAtStart ? 1 : 0) | (anchoredAtEnd ? 2 : 0))
+            data.appendVarint(UInt64(nibbleCount))
+            data.append(contentsOf: storage)
+        }
+        
+        /// Nil for the empty pattern written in place of a missing one.
+        init?(compiled raw: UnsafeRawBufferPointer, at position: inout Int, limit: Int) throws {
+            let compiled = try Self.compiled(raw, at: &position, limit: limit)
+            guard compiled.nibbleCount > 0 else { return nil }
+            
+            self.init(nibbleCount: compiled.nibbleCount,
+                      anchoredAtStart: compiled.anchors & 1 != 0,
+                      anchoredAtEnd: compiled.anchors & 2 != 0,
+                      storage: Array(raw[compiled.storage]))
+        }
+        
+        /// Reads the fields written by `write(to:)` and moves past them.
+        static func compiled(_ raw: UnsafeRawBufferPointer, at position: inout Int, limit: Int) throws -> (anchors: UInt8, nibbleCount: Int, storage: Range<Int>) {
+            guard position < limit else {
+                throw APDUCompiledScriptFormat.CorruptedFileError(reason: "invalid matcher at \(position)")
+            }
+            
+            let anchors = raw[position]
+            position += 1
+            
+            guard let nibbleCount = Int(exactly: try raw.varint(at: &position, limit: limit)), nibbleCount <= limit - position else {
+                throw APDUCompiledScriptFormat.CorruptedFileError(reason: "invalid matcher at \(position)")
+            }
+            
+            let length = (nibbleCount + 1) / 2 * 2 + (nibbleCount + 2) / 2 * 2
+            guard length <= limit - position else {
+                throw APDUCompiledScriptFormat.CorruptedFileError(reason: "matcher at \(position) is out of bounds")
+            }
+            
+            defer { position += length }
+            return (anchors, nibbleCount, position..<position + length)
+        }
+        
+        private init(nibbles: [UInt8?], anchoredAtStart: Bool, anchoredAtEnd: Bool) {
+            self.nibbleCount = nibbles.count
+            self.anchoredAtStart = anchoredAtStart
+            self.anchoredAtEnd = anchoredAtEnd
+            
+            func masks(_ nibbles: [UInt8?]) -> (values: [UInt8], masks: [UInt8]) {
+                var values = [UInt8](repeating: 0, count: (nibbles.count + 1) / 2)
+                var masks = values
+                
+                for (index, nibble) in nibbles.enumerated() {
+                    guard let nibble = nibble else { continue }
+                    let shift: UInt8 = index.isMultiple(of: 2) ? 4 : 0
+                    values[index / 2] |= nibble << shift
+                    masks[index / 2] |= 0x0F << shift
+                }
+                
+                return (values, masks)
+            }
+            
+            let aligned = masks(nibbles)
+            let shifted = masks([nil] + nibbles)
+            
+            self.alignedCount = aligned.values.count
+            self.shiftedCount = shifted.values.count
+            self.storage = aligned.values + aligned.masks + shifted.values + shifted.masks
+        }
+        
+        func matches(_ response: UnsafeRawBufferPointer) -> Bool {
+            let responseNibbles = response.count * 2
+            guard nibbleCount <= responseNibbles else { return false }
+            
+            let last = responseNibbles - nibbleCount
+            let first = anchoredAtEnd ? last : 0
+            let bound = anchoredAtStart ? min(0, last) : last
+            guard first <= bound else { return false }
+            
+            return storage.withUnsafeBufferPointer { storage in
+                for position in first...bound {
+                    let isAligned = position.isMultiple(of: 2)
+                    let count = isAligned ? alignedCount : shiftedCount
+                    let values = isAligned ? 0 : alignedCount * 2
+                    let masks = values + count
+                    let start = position / 2
+                    
+                    var index = 0
+                    while index < count, response[start + index] & storage[masks + index] == storage[values + index] {
+                        index += 1
+                    }
+                    
+                    if index == count {
+                        return true
+                    }
+                }
+                
+                return false
+            }
+        }
+    }
+}
@@ -18,10 +18,11 @@ class APDUSelectATROperation: APDUBaseOperation {
         responseATR?.hexEncodedString() ?? ""
     }
     
-    init(device: DeviceProtocol, name: String = "Selecting ATR..", atrData: Data?) {
+    init(id: UUID = UUID(), device: DeviceProtocol, name: String = "Selecting ATR..", atrData: Data?, responseATR: Data? = nil) {
         self.device = device
         self.atrData = atrData
-        super.init(type: .selectATR, deviceID: device.id, name: name)
+        self.responseATR = responseATR
+        super.init(id: id, type: .selectATR, deviceID: device.id, name: name)
     }
     
     required init(from decoder: Decoder) throws {
@@ -43,16 +44,29 @@ class APDUSelectATROperation: APDUBaseOperation {
         try container.encode(responseATR, forKey: .responseATR)
     }
     
+    override func encode(to writer: inout APDUSnapshotWriter) {
+        writer.write(atrData)
+        writer.write(responseATR)
+        super.encode(to: &writer)
+    }
+    
+    init(from reader: inout APDUSnapshotReader) throws {
+        self.atrData = try reader.readOptionalData()
+        self.responseATR = try reader.readOptionalData()
+        
+        try super.init(type: .selectATR, from: &reader)
+    }
+    
     override func tryStart() async throws {
         try Task.checkCancellation()
         await self.state(to: .running)
         let response = try await self.device.wakeUp()
+        self.responseATR = response
         
         guard let atrData = self.atrData else {
             return
         }
         
-        self.responseATR = response
         if response != atrData {
             throw OperationError.invalidResponse(atrData, response)
         }
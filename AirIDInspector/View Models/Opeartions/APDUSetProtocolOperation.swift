@@ -11,16 +11,16 @@ import AirIDDriver
 
 class APDUSetProtocolOperation: APDUBaseOperation {
     private unowned var device: DeviceProtocol!
-    private var cardProtocol: AIPCardProtocol
+    private(set) var cardProtocol: AIPCardProtocol
     
     override var description: String {
         "Protocol \(cardProtocol.description)"
     }
     
-    init(device: DeviceProtocol, name: String, protocol: AIPCardProtocol) {
+    init(id: UUID = UUID(), device: DeviceProtocol, name: String, protocol: AIPCardProtocol) {
         self.device = device
         self.cardProtocol = `protocol`
-        super.init(type: .setProtocol, deviceID: device.id, name: name)
+        super.init(id: id, type: .setProtocol, deviceID: device.id, name: name)
     }
     
     required init(from decoder: Decoder) throws {
@@ -29,6 +29,16 @@ class APDUSetProtocolOperation: APDUBaseOperation {
         try super.init(from: decoder)
     }
     
+    override func encode(to writer: inout APDUSnapshotWriter) {
+        writer.write(UInt32(cardProtocol.rawValue))
+        super.encode(to: &writer)
+    }
+    
+    init(from reader: inout APDUSnapshotReader) throws {
+        self.cardProtocol = AIPCardProtocol(rawValue: UInt(try reader.read(UInt32.self)))
+        try super.init(type: .setProtocol, from: &reader)
+    }
+    
     override func setDevice(_ device: DeviceProtocol) {
         self.device = device
     }
@@ -21,17 +21,33 @@ class APDUTestOperation: APDUBaseOperation {
     let expectedResponse: String
     let options: Options
     
+    /// Compiled once from `expectedResponse`, so running the operation again doesn't parse the pattern again.
+    let matcher: APDUResponseMatcher
+    
     private unowned var device: DeviceProtocol!
     
-    init(device: DeviceProtocol,
+    /**
+     - parameter matcher: `expectedResponse` already compiled with `options`, e.g. read from a compiled script.
+     - parameter interningTable: shares the command, its name and the matcher with the other operations created through the same table.
+     */
+    init(id: UUID = UUID(),
+         device: DeviceProtocol,
          data: Data,
          expectedResponse: String,
-         options: Options = .defaultOptions) {
+         options: Options = .defaultOptions,
+         matcher: APDUResponseMatcher? = nil,
+         interningTable: APDUInterningTable? = nil) {
+        let command = interningTable?.command(data) ?? (data: data, name: data.hexEncodedString())
+        let matcher = interningTable?.matcher(for: expectedResponse, options: options, compiled: matcher)
+            ?? matcher
+            ?? APDUResponseMatcher(expectedResponse: expectedResponse, options: options)
+        
         self.device = device
-        self.data = data
-        self.expectedResponse = expectedResponse
+        self.data = command.data
+        self.expectedResponse = matcher.expectedResponse
         self.options = options
-        super.init(type: .apduTest, deviceID: device.id, name: data.hexEncodedString())
+        self.matcher = matcher
+        super.init(id: id, type: .apduTest, deviceID: device.id, name: command.name)
     }
     
     required init(from decoder: Decoder) throws {
@@ -39,6 +55,7 @@ class APDUTestOperation: APDUBaseOperation {
         self.data = try container.decode(Data.self, forKey: .data)
         self.expectedResponse = try container.decode(String.self, forKey: .expectedResponse)
         self.options = try container.decodeIfPresent(Options.self, forKey: .options) ?? .defaultOptions
+        self.matcher = APDUResponseMatcher(expectedResponse: expectedResponse, options: options)
         
         try super.init(from: decoder)
     }
@@ -51,6 +68,22 @@ class APDUTestOperation: APDUBaseOperation {
         try container.encode(options, forKey: .options)
     }
     
+    override func encode(to writer: inout APDUSnapshotWriter) {
+        writer.write(data)
+        writer.write(expectedResponse)
+        writer.write(options.rawValue)
+        super.encode(to: &writer)
+    }
+    
+    init(from reader: inout APDUSnapshotReader) throws {
+        self.data = try reader.readData()
+        self.expectedResponse = try reader.readString()
+        self.options = Options(rawValue: try reader.read(Int.self))
+        self.matcher = APDUResponseMatcher(expectedResponse: expectedResponse, options: options)
+        
+        try super.init(type: .apduTest, from: &reader)
+    }
+    
     override func setDevice(_ device: DeviceProtocol) {
         self.device = device
     }
@@ -59,33 +92,13 @@ class APDUTestOperation: APDUBaseOperation {
         try Task.checkCancellation()
         await self.state(to: .running)
         
-        var response: Data?
+        var response = Data()
         try await self.benchTimer.measure {
             response = try await self.device.sendAPDU(with: data)
         }.append(to: self.measurements)
         
-        let lastTwoBytes = response![(response!.count - 2)...(response!.endIndex - 1)]
-        
-        if options.contains(.evaluateRegex) {
-            let responseString = response!.hexEncodedString()
-            let expectedString = expectedResponse
-            
-            guard responseString.range(of: expectedString,
-                                       options: .regularExpression) != nil else {
-                throw OperationError.invalidResponse(lastTwoBytes, expectedResponse.hexadecimal ?? Data())
-            }
-            
-            return
-        }
-        
-        guard let hexExpectedResponse = expectedResponse.hexadecimal else {
-            throw OperationError.serializationError("Expected Response isn't hex format")
-        }
-        
-        if expectedResponse.count == 2, lastTwoBytes != hexExpectedResponse {
-            throw OperationError.invalidResponse(lastTwoBytes, hexExpectedResponse)
-        } else if response != hexExpectedResponse {
-            throw OperationError.invalidResponse(response!, hexExpectedResponse)
+        if let failure = matcher.failure(for: response) {
+            throw failure
         }
     }
     
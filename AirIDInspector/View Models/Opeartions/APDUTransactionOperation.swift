@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUTransactionOperation.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/// What happens to the card once a transaction is over, the `dwDisposition` of `SCardEndTransaction`.
+enum APDUTransactionDisposition: UInt8, CaseIterable, Codable {
+    /// the card is left as it is
+    case leave
+    /// warm reset
+    case reset
+    /// the card is powered down
+    case unpower
+    
+    var name: String {
+        switch self {
+        case .leave: return "Leave"
+        case .reset: return "Reset"
+        case .unpower: return "Unpower"
+        }
+    }
+}
+
+/// One end of a transaction block of a script.
+enum APDUTransactionBoundary: Equatable {
+    case begin
+    case end(APDUTransactionDisposition)
+    
+    /// A single byte, 0 for the beginning and 1 + the disposition for the end.
+    var code: UInt8 {
+        switch self {
+        case .begin: return 0
+        case .end(let disposition): return 1 + disposition.rawValue
+        }
+    }
+    
+    init?(code: UInt8) {
+        if code == 0 {
+            self = .begin
+        } else if let disposition = APDUTransactionDisposition(rawValue: code - 1) {
+            self = .end(disposition)
+        } else {
+            return nil
+        }
+    }
+    
+    var name: String {
+        switch self {
+        case .begin: return "Begin Transaction.."
+        case .end(let disposition): return "End Transaction (\(disposition.name)).."
+        }
+    }
+}
+
+/**
+ Holds the card across the APDUs following it, or releases it and applies the disposition.
+ */
+class APDUTransactionOperation: APDUBaseOperation {
+    private unowned var device: DeviceProtocol!
+    private(set) var boundary: APDUTransactionBoundary
+    
+    init(id: UUID = UUID(), device: DeviceProtocol, boundary: APDUTransactionBoundary) {
+        self.device = device
+        self.boundary = boundary
+        super.init(id: id, type: .transaction, deviceID: device.id, name: boundary.name)
+    }
+    
+    required init(from decoder: Decoder) throws {
+        let container = try decoder.container(keyedBy: CodingKeys.self)
+        let code = try container.decode(UInt8.self, forKey: .boundary)
+        guard let boundary = APDUTransactionBoundary(code: code) else {
+            throw DecodingError.dataCorruptedError(forKey: .boundary, in: container, debugDescription: "unknown transaction boundary \(code)")
+        }
+        
+        self.boundary = boundary
+        try super.init(from: decoder)
+    }
+    
+    override func encode(to encoder: Encoder) throws {
+        try super.encode(to: encoder)
+        var container = encoder.container(keyedBy: CodingKeys.self)
+        try container.encode(boundary.code, forKey: .boundary)
+    }
+    
+    override func encode(to writer: inout APDUSnapshotWriter) {
+        writer.write(boundary.code)
+        super.encode(to: &writer)
+    }
+    
+    init(from reader: inout APDUSnapshotReader) throws {
+        let code = try reader.read(UInt8.self)
+        guard let boundary = APDUTransactionBoundary(code: code) else {
+            throw APDUSnapshotFormat.CorruptedSnapshotError(reason: "unknown transaction boundary \(code)")
+        }
+        
+        self.boundary = boundary
+        try super.init(type: .transaction, from: &reader)
+    }
+    
+    override func setDevice(_ device: DeviceProtocol) {
+        self.device = device
+    }
+    
+    override func tryStart() async throws {
+        try Task.checkCancellation()
+        await self.state(to: .running)
+        
+        switch boundary {
+        case .begin:
+            try await device.beginTransaction()
+        case .end(let disposition):
+            try await device.endTransaction(disposition: disposition)
+        }
+    }
+    
+    enum CodingKeys: String, CodingKey {
+        case boundary
+    }
+}
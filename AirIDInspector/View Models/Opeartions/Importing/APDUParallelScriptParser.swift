@@ -0,0 +1,227 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUParallelScriptParser.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Parses a script held in memory on all cores.
+ 
+ The body is cut into chunks at line boundaries, a first concurrent pass counts the content lines of every chunk so each boundary can be moved onto a request/response pair boundary, and a second concurrent pass parses the chunks into entries which are stitched back in order. The first chunk also carries the header, so the ATR and protocol entries still come first.
+ 
+ A table is filled from `entries(in:)` without creating any operation, `operations(in:for:)` is for callers which need operation objects.
+ */
+enum APDUParallelScriptParser {
+    static let minimumChunkSize = 64 * 1024
+    
+    private struct ChunkScan {
+        var contentLines = 0
+        /// Offset right after the first content line of the chunk
+        var firstContentEnd: Int?
+    }
+    
+    private struct ParsedChunk {
+        var entries: [APDUScriptEntry]
+        var pairsCount: Int
+    }
+    
+    /// The entries of `string` in order.
+    static func entries(in string: String, maximumChunks: Int = ProcessInfo.processInfo.activeProcessorCount * 4) async throws -> [APDUScriptEntry] {
+        let parsed = try await parsedChunks(in: Array(string.utf8), maximumChunks: maximumChunks)
+        
+        var entries: [APDUScriptEntry] = []
+        entries.reserveCapacity(parsed.reduce(0) { $0 + $1.entries.count })
+        parsed.forEach { entries.append(contentsOf: $0.entries) }
+        
+        return entries
+    }
+    
+    /// The operations of `string` in order, the chunks are turned into operations concurrently too.
+    static func operations(in string: String,
+                           for device: DeviceProtocol,
+                           interningTable: APDUInterningTable = .init(),
+                           maximumChunks: Int = ProcessInfo.processInfo.activeProcessorCount * 4) async throws -> [APDUBaseOperation] {
+        let parsed = try await parsedChunks(in: Array(string.utf8), maximumChunks: maximumChunks)
+        
+        // the header comes with the first chunk, the other chunks need it for the ids of their tests
+        parsed.first?.entries.prefix { $0.type.isHeader }.forEach(interningTable.apply)
+        
+        let chunks = await withTaskGroup(of: (Int, [APDUBaseOperation]).self) { group -> [[APDUBaseOperation]] in
+            for (index, chunk) in parsed.enumerated() {
+                group.addTask { (index, chunk.entries.map { $0.operation(for: device, interningTable: interningTable) }) }
+            }
+            
+            var chunks = Array(repeating: [APDUBaseOperation](), count: parsed.count)
+            for await (index, operations) in group {
+                chunks[index] = operations
+            }
+            
+            return chunks
+        }
+        
+        var operations: [APDUBaseOperation] = []
+        operations.reserveCapacity(chunks.reduce(0) { $0 + $1.count })
+        chunks.forEach { operations.append(contentsOf: $0) }
+        
+        return operations
+    }
+    
+    private static func parsedChunks(in bytes: [UInt8], maximumChunks: Int) async throws -> [ParsedChunk] {
+        let bodyStart = bodyOffset(in: bytes)
+        let chunks = split(bytes, from: bodyStart, maximumChunks: maximumChunks)
+        
+        let scans = await withTaskGroup(of: (Int, ChunkScan).self) { group -> [ChunkScan] in
+            for (index, chunk) in chunks.enumerated() {
+                group.addTask { (index, scan(bytes, chunk)) }
+            }
+            
+            var scans = Array(repeating: ChunkScan(), count: chunks.count)
+            for await (index, result) in group {
+                scans[index] = result
+            }
+            
+            return scans
+        }
+        
+        let ranges = alignedRanges(chunks, scans: scans, bodyStart: bodyStart)
+        
+        let parsed = try await withThrowingTaskGroup(of: (Int, ParsedChunk).self) { group -> [ParsedChunk] in
+            for (index, range) in ranges.enumerated() {
+                group.addTask {
+                    try Task.checkCancellation()
+                    return (index, parse(bytes, range, isFirst: index == 0))
+                }
+            }
+            
+            var parsed = Array(repeating: ParsedChunk(entries: [], pairsCount: 0), count: ranges.count)
+            for try await (index, chunk) in group {
+                parsed[index] = chunk
+            }
+            
+            return parsed
+        }
+        
+        guard parsed.reduce(0, { $0 + $1.pairsCount }) > 0 else {
+            throw APDUTestSourceString.InvalidFileError()
+        }
+        
+        return parsed
+    }
+    
+    /// Offset of the first line which isn't part of the header.
+    private static func bodyOffset(in bytes: [UInt8]) -> Int {
+        var parser = APDUScriptParser()
+        var header: [APDUScriptEntry] = []
+        var bodyStart = bytes.count
+        
+        forEachLine(in: bytes, 0..<bytes.count) { line in
+            parser.consume(line: String(decoding: bytes[line], as: UTF8.self), into: &header)
+            if !parser.isReadingHeader {
+                bodyStart = line.lowerBound
+                return false
+            }
+            
+            return true
+        }
+        
+        return bodyStart
+    }
+    
+    /// Cuts `bytes[start...]` into roughly equal chunks, each ending right after a newline.
+    private static func split(_ bytes: [UInt8], from start: Int, maximumChunks: Int) -> [Range<Int>] {
+        let length = bytes.count - start
+        let count = max(1, min(maximumChunks, length / minimumChunkSize))
+        let target = length / count
+        
+        var chunks: [Range<Int>] = []
+        var lower = start
+        
+        for _ in 1..<count {
+            let guess = max(lower, lower + target)
+            guard guess < bytes.count, let newline = bytes[guess...].firstIndex(of: UInt8(ascii: "\n")) else {
+                break
+            }
+            
+            chunks.append(lower..<newline + 1)
+            lower = newline + 1
+        }
+        
+        chunks.append(lower..<bytes.count)
+        return chunks
+    }
+    
+    private static func scan(_ bytes: [UInt8], _ chunk: Range<Int>) -> ChunkScan {
+        var result = ChunkScan()
+        
+        forEachLine(in: bytes, chunk) { line in
+            if APDUScriptParser.isContent(utf8: bytes[line]) {
+                result.contentLines += 1
+                if result.firstContentEnd == nil {
+                    result.firstContentEnd = min(line.upperBound + 1, chunk.upperBound)
+                }
+            }
+            
+            return true
+        }
+        
+        return result
+    }
+    
+    /**
+     Moves every chunk boundary which would separate a request from its response past that response. A chunk without content lines on such a boundary is merged into the previous one.
+     */
+    private static func alignedRanges(_ chunks: [Range<Int>], scans: [ChunkScan], bodyStart: Int) -> [Range<Int>] {
+        var boundaries: [Int] = [0]
+        var contentLines = 0
+        
+        for (chunk, scan) in zip(chunks, scans) {
+            if chunk.lowerBound != bodyStart {
+                if contentLines.isMultiple(of: 2) {
+                    boundaries.append(chunk.lowerBound)
+                } else if let firstContentEnd = scan.firstContentEnd {
+                    boundaries.append(firstContentEnd)
+                }
+            }
+            
+            contentLines += scan.contentLines
+        }
+        
+        boundaries.append(chunks.last?.upperBound ?? bodyStart)
+        
+        return zip(boundaries, boundaries.dropFirst()).map { $0..<$1 }
+    }
+    
+    private static func parse(_ bytes: [UInt8], _ range: Range<Int>, isFirst: Bool) -> ParsedChunk {
+        var parser = APDUScriptParser(expectsHeader: isFirst)
+        var entries: [APDUScriptEntry] = []
+        
+        forEachLine(in: bytes, range) { line in
+            if isFirst || APDUScriptParser.isContent(utf8: bytes[line]) {
+                parser.consume(line: String(decoding: bytes[line], as: UTF8.self), into: &entries)
+            }
+            
+            return true
+        }
+        
+        if isFirst {
+            parser.end(into: &entries)
+        }
+        
+        return ParsedChunk(entries: entries, pairsCount: parser.pairsCount)
+    }
+    
+    /// Calls `body` with the range of every line in `range`, without the newline. Return false to stop.
+    private static func forEachLine(in bytes: [UInt8], _ range: Range<Int>, _ body: (Range<Int>) -> Bool) {
+        var lower = range.lowerBound
+        
+        while lower < range.upperBound {
+            let upper = bytes[lower..<range.upperBound].firstIndex(of: UInt8(ascii: "\n")) ?? range.upperBound
+            guard body(lower..<upper) else { return }
+            lower = upper + 1
+        }
+    }
+}
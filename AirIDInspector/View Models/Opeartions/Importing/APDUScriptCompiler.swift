@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUScriptCompiler.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+import AirIDDriver
+
+/**
+ Layout of compiled APDU scripts, all integers are little endian.
+ 
+ ```
+ header   magic "APDB" | version: UInt16 | flags: UInt16 | protocol: UInt32 | indexStride: UInt32
+          operationCount: UInt64 | indexOffset: UInt64 | atrLength: UInt32 | ATR bytes
+ records  commandLength: varint | command bytes | responseLength: varint | response bytes | matcher
+ index    offset of every `indexStride`th record: UInt64
+ ```
+ 
+ `matcher` is the expected response compiled with the default options, see `APDUResponseMatcher.write(to:)`. Loading a record copies its masks instead of analysing the response text again.
+ */
+enum APDUCompiledScriptFormat {
+    static let magic: [UInt8] = Array("APDB".utf8)
+    static let version: UInt16 = 2
+    static let headerSize = 36
+    static let defaultIndexStride = 256
+    static let fileExtension = "apdub"
+    
+    struct Flags: OptionSet {
+        let rawValue: UInt16
+        
+        static let hasProtocol = Flags(rawValue: 1 << 0)
+        static let hasATR = Flags(rawValue: 1 << 1)
+    }
+    
+    struct CorruptedFileError: LocalizedError {
+        let reason: String
+        
+        var errorDescription: String? {
+            "Compiled script is corrupted: \(reason)"
+        }
+    }
+}
+
+/**
+ Compiles APDU test scripts in the README text format into the binary format read by `APDUTestSourceCompiled`.
+ 
+ The text is streamed through `APDUScriptFileReader`, records are written as they're parsed, so compiling doesn't need the script in memory either.
+ */
+struct APDUScriptCompiler {
+    let indexStride: Int
+    
+    init(indexStride: Int = APDUCompiledScriptFormat.defaultIndexStride) {
+        precondition(indexStride > 0)
+        self.indexStride = indexStride
+    }
+    
+    /// Compiles the text script at `sourceURL` into `destinationURL`, returns the number of compiled operations.
+    @discardableResult
+    func compile(fileAt sourceURL: URL, to destinationURL: URL) throws -> Int {
+        let reader = APDUScriptFileReader(fileURL: sourceURL)
+        return try compile(to: destinationURL) { try reader.nextEntry() }
+    }
+    
+    @discardableResult
+    func compile(string: String, to destinationURL: URL) throws -> Int {
+        let reader = APDUScriptFileReader(string: string)
+        return try compile(to: destinationURL) { try reader.nextEntry() }
+    }
+    
+    /// Compiles into a file next to `destinationURL` and moves it into place once complete, a failed compile leaves an existing script untouched.
+    private func compile(to destinationURL: URL, nextEntry: () throws -> APDUScriptEntry?) throws -> Int {
+        let partialURL = destinationURL.appendingPathExtension("partial")
+        FileManager.default.createFile(atPath: partialURL.path, contents: nil)
+        
+        let count: Int
+        do {
+            let handle = try FileHandle(forWritingTo: partialURL)
+            defer { try? handle.close() }
+            
+            count = try compile(to: handle, nextEntry: nextEntry)
+        } catch {
+            try? FileManager.default.removeItem(at: partialURL)
+            throw error
+        }
+        
+        if FileManager.default.fileExists(atPath: destinationURL.path) {
+            _ = try FileManager.default.replaceItemAt(destinationURL, withItemAt: partialURL)
+        } else {
+            try FileManager.default.moveItem(at: partialURL, to: destinationURL)
+        }
+        
+        return count
+    }
+    
+    private func compile(to handle: FileHandle, nextEntry: () throws -> APDUScriptEntry?) throws -> Int {
+        var cardProtocol: AIPCardProtocol?
+        var atrData: Data?
+        var isHeaderWritten = false
+        
+        var buffer = Data()
+        var offset = 0
+        var count = 0
+        var index: [UInt64] = []
+        /// Compiled matchers by expected response, scripts repeat the same few responses.
+        var matchers: [String: Data] = [:]
+        
+        func flush(force: Bool = false) throws {
+            guard force || buffer.count >= 1 << 20 else { return }
+            try handle.write(contentsOf: buffer)
+            buffer.removeAll(keepingCapacity: true)
+        }
+        
+        func writeHeader() {
+            isHeaderWritten = true
+            buffer.append(header(cardProtocol: cardProtocol, atrData: atrData, count: 0, indexOffset: 0))
+            offset = buffer.count
+        }
+        
+        while let entry = try nextEntry() {
+            switch entry {
+            case .selectATR(let data):
+                atrData = data
+            case .setProtocol(let value):
+                cardProtocol = value
+            case .transaction:
+                // the format only has room for pairs
+                throw APDUScriptDirective.InvalidDirectiveError(reason: "transactions can't be compiled")
+            case .fixture:
+                // the setup pairs are compiled like any other, they just run every time
+                break
+            case .test(let command, let expectedResponse):
+                if !isHeaderWritten {
+                    writeHeader()
+                }
+                
+                if count % indexStride == 0 {
+                    index.append(UInt64(offset))
+                }
+                
+                let response = Data(expectedResponse.utf8)
+                let start = buffer.count
+                buffer.appendVarint(UInt64(command.count))
+                buffer.append(command)
+                buffer.appendVarint(UInt64(response.count))
+                buffer.append(response)
+                
+                if let matcher = matchers[expectedResponse] {
+                    buffer.append(matcher)
+                } else {
+                    var matcher = Data()
+                    APDUResponseMatcher(expectedResponse: expectedResponse).write(to: &matcher)
+                    matchers[expectedResponse] = matcher
+                    buffer.append(matcher)
+                }
+                
+                offset += buffer.count - start
+                count += 1
+                try flush()
+            }
+        }
+        
+        if !isHeaderWritten {
+            writeHeader()
+        }
+        
+        let indexOffset = offset
+        for entry in index {
+            buffer.appendLittleEndian(entry)
+        }
+        
+        try flush(force: true)
+        
+        // now that the count and the index position are known, rewrite the header in place
+        try handle.seek(toOffset: 0)
+        try handle.write(contentsOf: header(cardProtocol: cardProtocol, atrData: atrData, count: count, indexOffset: indexOffset))
+        
+        return count
+    }
+    
+    private func header(cardProtocol: AIPCardProtocol?, atrData: Data?, count: Int, indexOffset: Int) -> Data {
+        var flags: APDUCompiledScriptFormat.Flags = []
+        if cardProtocol != nil { flags.insert(.hasProtocol) }
+        if atrData != nil { flags.insert(.hasATR) }
+        
+        var header = Data(APDUCompiledScriptFormat.magic)
+        header.appendLittleEndian(APDUCompiledScriptFormat.version)
+        header.appendLittleEndian(flags.rawValue)
+        header.appendLittleEndian(UInt32(cardProtocol?.rawValue ?? 0))
+        header.appendLittleEndian(UInt32(indexStride))
+        header.appendLittleEndian(UInt64(count))
+        header.appendLittleEndian(UInt64(indexOffset))
+        header.appendLittleEndian(UInt32(atrData?.count ?? 0))
+        header.append(atrData ?? Data())
+        
+        return header
+    }
+}
+
+extension Data {
+    mutating func appendLittleEndian<T: FixedWidthInteger>(_ value: T) {
+        Swift.withUnsafeBytes(of: value.littleEndian) { self.append(contentsOf: $0) }
+    }
+    
+    /// Appends `value` as LEB128 varint.
+    mutating func appendVarint(_ value: UInt64) {
+        var value = value
+        while value >= 0x80 {
+            self.append(UInt8(truncatingIfNeeded: value) | 0x80)
+            value >>= 7
+        }
+        
+        self.append(UInt8(value))
+    }
+}
@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUScriptDirective.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Block directives of the script format, accepted between request/response pairs.
+ 
+ ```
+ REPEAT 10000
+ 00B0000000
+ 9000
+ INCLUDE select.txt
+ END
+ BEGIN TRANSACTION
+ 00B0000000
+ 9000
+ END TRANSACTION RESET
+ ```
+ 
+ `REPEAT n` runs the lines until the matching `END` n times, blocks can be nested. `INCLUDE path` runs the pairs of another script, relative paths are resolved against the including script, headers of included scripts are ignored. `BEGIN TRANSACTION` holds the card for the pairs until `END TRANSACTION`, which leaves the card as it is, or resets or powers it down with `RESET` or `UNPOWER`. `BEGIN SETUP` ... `END SETUP` before the first pair marks the pairs setting the card up, see `APDUOperationTable.fixtureRows`, it's ignored in included scripts.
+ */
+enum APDUScriptDirective: Equatable {
+    case repeatBlock(count: Int)
+    case end
+    case include(path: String)
+    case beginTransaction
+    case endTransaction(APDUTransactionDisposition)
+    case beginSetup
+    case endSetup
+    
+    struct InvalidDirectiveError: LocalizedError {
+        let reason: String
+        
+        var errorDescription: String? {
+            "Invalid directive: \(reason)"
+        }
+    }
+    
+    /// Parses a directive line, nil for any other line.
+    init?<Line: StringProtocol>(line rawLine: Line) {
+        let line = rawLine.trimmingCharacters(in: .whitespaces)
+        
+        if line == "END" {
+            self = .end
+        } else if line.hasPrefix("REPEAT "), let count = Int(line.dropFirst(7).trimmingCharacters(in: .whitespaces)), count >= 0 {
+            self = .repeatBlock(count: count)
+        } else if line == "BEGIN TRANSACTION" {
+            self = .beginTransaction
+        } else if line == "BEGIN SETUP" {
+            self = .beginSetup
+        } else if line == "END SETUP" {
+            self = .endSetup
+        } else if line.hasPrefix("END TRANSACTION") {
+            switch line.dropFirst(15).trimmingCharacters(in: .whitespaces) {
+            case "", "LEAVE": self = .endTransaction(.leave)
+            case "RESET": self = .endTransaction(.reset)
+            case "UNPOWER": self = .endTransaction(.unpower)
+            default: return nil
+            }
+        } else if line.hasPrefix("INCLUDE ") {
+            let path = line.dropFirst(8).trimmingCharacters(in: .whitespaces)
+            guard !path.isEmpty else { return nil }
+            self = .include(path: path)
+        } else {
+            return nil
+        }
+    }
+    
+    /// Whether any line of `string` begins with a directive keyword, cheap enough to decide how to parse a script.
+    static func containsDirectives(in string: String) -> Bool {
+        var isLineStart = true
+        var utf8 = Substring(string).utf8
+        
+        while let byte = utf8.first {
+            if isLineStart, byte == UInt8(ascii: "R") || byte == UInt8(ascii: "I") || byte == UInt8(ascii: "E") || byte == UInt8(ascii: "B") {
+                let line = utf8.prefix { $0 != UInt8(ascii: "\n") }
+                if APDUScriptDirective(line: String(decoding: line, as: UTF8.self)) != nil {
+                    return true
+                }
+            }
+            
+            isLineStart = byte == UInt8(ascii: "\n") || (isLineStart && APDUScriptParser.isWhitespace(byte))
+            utf8.removeFirst()
+        }
+        
+        return false
+    }
+}
+
+/**
+ The recorded body of a `REPEAT` block, replayed once per repetition.
+ */
+indirect enum APDUScriptNode {
+    case entry(APDUScriptEntry)
+    case repeated(count: Int, body: [APDUScriptNode])
+    case include(URL)
+}
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUScriptFileWatcher.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Calls `onChange` on its own queue whenever the watched script is written to.
+ 
+ Bursts of events, like an editor saving in several writes, are coalesced into a single call. Editors saving atomically replace the file, the watcher then follows the new file at the same path.
+ */
+final class APDUScriptFileWatcher {
+    static let coalescingInterval: DispatchTimeInterval = .milliseconds(200)
+    
+    let fileURL: URL
+    
+    private let queue = DispatchQueue(label: "APDUScriptFileWatcher", qos: .utility)
+    private let onChange: () -> Void
+    private var source: DispatchSourceFileSystemObject?
+    private var isChangePending = false
+    
+    init(fileURL: URL, onChange: @escaping () -> Void) {
+        self.fileURL = fileURL
+        self.onChange = onChange
+    }
+    
+    deinit {
+        source?.cancel()
+    }
+    
+    func start() {
+        queue.async {
+            self.openIfNeeded()
+        }
+    }
+    
+    func stop() {
+        queue.sync {
+            source?.cancel()
+            source = nil
+        }
+    }
+    
+    private func openIfNeeded() {
+        guard source == nil else { return }
+        
+        let descriptor = open(fileURL.path, O_EVTONLY)
+        guard descriptor >= 0 else { return }
+        
+        let source = DispatchSource.makeFileSystemObjectSource(fileDescriptor: descriptor,
+                                                               eventMask: [.write, .extend, .delete, .rename],
+                                                               queue: queue)
+        source.setEventHandler { [weak self, unowned source] in
+            self?.handle(source.data)
+        }
+        
+        source.setCancelHandler {
+            close(descriptor)
+        }
+        
+        source.resume()
+        self.source = source
+    }
+    
+    private func handle(_ event: DispatchSource.FileSystemEvent) {
+        if event.contains(.delete) || event.contains(.rename) {
+            // the descriptor still points to the replaced file, reopened once the burst is over
+            source?.cancel()
+            source = nil
+        }
+        
+        guard !isChangePending else { return }
+        isChangePending = true
+        
+        queue.asyncAfter(deadline: .now() + Self.coalescingInterval) { [weak self] in
+            guard let self = self else { return }
+            
+            self.isChangePending = false
+            self.openIfNeeded()
+            self.onChange()
+        }
+    }
+}
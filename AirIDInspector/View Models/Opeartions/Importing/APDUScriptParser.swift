@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUScriptParser.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+import AirIDDriver
+
+/**
+ A single item of an APDU test script, independent of any device.
+ */
+enum APDUScriptEntry {
+    case selectATR(Data?)
+    case setProtocol(AIPCardProtocol)
+    case test(command: Data, expectedResponse: String)
+    case transaction(APDUTransactionBoundary)
+    case fixture(APDUFixtureBoundary)
+    
+    /**
+     - parameter interningTable: also follows the header entries, pass the same table for all the entries of a script so tests get the ids of their header.
+     */
+    func operation(for device: DeviceProtocol, interningTable: APDUInterningTable? = nil) -> APDUBaseOperation {
+        let id = interningTable?.identifier(for: self) ?? APDUOperationIdentity.identifier(for: self, in: .init())
+        
+        switch self {
+        case .selectATR(let atrData?):
+            return APDUSelectATROperation(id: id, device: device, name: "Select ATR..", atrData: atrData)
+        case .selectATR(nil):
+            return APDUSelectATROperation(id: id, device: device, name: "Selecting ATR..", atrData: nil)
+        case .setProtocol(let cardProtocol):
+            return APDUSetProtocolOperation(id: id, device: device, name: "Set Protocol..", protocol: cardProtocol)
+        case .test(let command, let expectedResponse):
+            return APDUTestOperation(id: id, device: device, data: command, expectedResponse: expectedResponse, interningTable: interningTable)
+        case .transaction(let boundary):
+            return APDUTransactionOperation(id: id, device: device, boundary: boundary)
+        case .fixture(let boundary):
+            return APDUFixtureOperation(id: id, device: device, boundary: boundary)
+        }
+    }
+}
+
+/**
+ Incremental parser of the APDU test format described in the README, fed one line at a time.
+ 
+ The optional `T=` and `ATR:` headers are only accepted before the first request, blank lines and lines beginning with `#` are skipped, every other line is part of a request/response pair. The parser never looks back and doesn't create any operation, so it can be driven by any line producer without keeping the script around.
+ */
+struct APDUScriptParser {
+    private enum Phase {
+        case header
+        case body
+    }
+    
+    private var phase: Phase
+    private var cardProtocol: AIPCardProtocol?
+    private var atrData: Data?
+    private var pendingRequest: Data?
+    private var hasPendingRequest = false
+    
+    /// The number of request/response pairs parsed so far.
+    private(set) var pairsCount = 0
+    
+    /// Whether the parser still accepts header lines.
+    var isReadingHeader: Bool {
+        phase == .header
+    }
+    
+    /// Whether the next content line is the response of a request, i.e. the parser isn't between two pairs.
+    var isAwaitingResponse: Bool {
+        hasPendingRequest
+    }
+    
+    /**
+     - parameter expectsHeader: pass false to parse a slice of a script body, where header lines aren't allowed anymore.
+     */
+    init(expectsHeader: Bool = true) {
+        self.phase = expectsHeader ? .header : .body
+    }
+    
+    /// Parses a whole script held in memory.
+    static func entries<S: StringProtocol>(in string: S) throws -> [APDUScriptEntry] {
+        var parser = APDUScriptParser()
+        var entries: [APDUScriptEntry] = []
+        
+        for line in string.split(whereSeparator: \.isNewline) {
+            parser.consume(line: line, into: &entries)
+        }
+        
+        try parser.finish(into: &entries)
+        return entries
+    }
+    
+    /**
+     Whether a line takes part in the script, i.e. isn't blank or a comment. Only ASCII whitespace counts as blank, so this can be decided on raw bytes.
+     */
+    static func isContent<Line: Collection>(utf8 line: Line) -> Bool where Line.Element == UInt8 {
+        guard let first = line.first(where: { !isWhitespace($0) }) else {
+            return false
+        }
+        
+        return first != UInt8(ascii: "#")
+    }
+    
+    @inline(__always)
+    static func isWhitespace(_ byte: UInt8) -> Bool {
+        byte == 0x20 || (byte >= 0x09 && byte <= 0x0D)
+    }
+    
+    mutating func consume<Line: StringProtocol>(line rawLine: Line, into entries: inout [APDUScriptEntry]) {
+        let utf8 = rawLine.utf8
+        
+        guard Self.isContent(utf8: utf8),
+              let start = utf8.firstIndex(where: { !Self.isWhitespace($0) }),
+              let end = utf8.lastIndex(where: { !Self.isWhitespace($0) }) else {
+            return
+        }
+        
+        let line = rawLine[start...end]
+        
+        if phase == .header {
+            if cardProtocol == nil, atrData == nil, line.hasPrefix("T=") {
+                cardProtocol = Self.cardProtocol(from: line.dropFirst(2))
+                return
+            }
+            
+            if atrData == nil, line.hasPrefix("ATR:") {
+                atrData = line.dropFirst(4).hexadecimal
+                return
+            }
+            
+            flushHeader(into: &entries)
+        }
+        
+        guard hasPendingRequest else {
+            pendingRequest = line.hexadecimal
+            hasPendingRequest = true
+            return
+        }
+        
+        hasPendingRequest = false
+        
+        // requests which aren't hex are skipped together with their response
+        if let data = pendingRequest {
+            entries.append(.test(command: data, expectedResponse: String(line)))
+            pairsCount += 1
+        }
+        
+        pendingRequest = nil
+    }
+    
+    /**
+     Flushes whatever is left once the input is exhausted, a dangling request without response is dropped.
+     */
+    mutating func finish(into entries: inout [APDUScriptEntry]) throws {
+        end(into: &entries)
+        
+        if pairsCount == 0 {
+            throw APDUTestSourceString.InvalidFileError()
+        }
+    }
+    
+    /// Same as `finish(into:)`, without requiring any pair to be parsed.
+    mutating func end(into entries: inout [APDUScriptEntry]) {
+        if phase == .header {
+            flushHeader(into: &entries)
+        }
+    }
+    
+    private mutating func flushHeader(into entries: inout [APDUScriptEntry]) {
+        phase = .body
+        
+        entries.append(.selectATR(atrData))
+        
+        if let cardProtocol = cardProtocol {
+            entries.append(.setProtocol(cardProtocol))
+        }
+    }
+    
+    static func cardProtocol<S: StringProtocol>(from value: S) -> AIPCardProtocol {
+        switch value {
+        case "1": return .T1
+        case "0": return .T0
+        default: return .tx
+        }
+    }
+}
@@ -0,0 +1,378 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUSnapshotCodec.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Layout of binary snapshots, all integers are little endian.
+ 
+ ```
+ header        magic "APDS" | version: UInt16 | reserved: UInt16 | deviceIdentifier: 16 bytes
+               operationCount: UInt64 | tableOffset: UInt64
+ records       type: UInt8 | fields of the operation subclass | fields of APDUBaseOperation
+ measurements  durationsCount: varint | zigzag varint delta to the previous duration, per duration
+ table         recordOffset: UInt64 | measurementsOffset: UInt64, per operation
+ ```
+ 
+ Consecutive durations of the same operation are close to each other, so their deltas mostly fit in two or three bytes instead of eight.
+ */
+enum APDUSnapshotFormat {
+    static let magic: [UInt8] = Array("APDS".utf8)
+    static let version: UInt16 = 1
+    static let headerSize = 40
+    
+    struct CorruptedSnapshotError: LocalizedError {
+        let reason: String
+        
+        var errorDescription: String? {
+            "Snapshot is corrupted: \(reason)"
+        }
+    }
+    
+    static func isSnapshot(_ data: Data) -> Bool {
+        data.count >= headerSize && data.prefix(4).elementsEqual(magic)
+    }
+    
+    static func encode(_ operations: [APDUBaseOperation], deviceIdentifier: UUID) -> Data {
+        var records = APDUSnapshotWriter()
+        var measurements = APDUSnapshotWriter()
+        var offsets: [(record: Int, measurements: Int)] = []
+        offsets.reserveCapacity(operations.count)
+        
+        for operation in operations {
+            offsets.append((records.data.count, measurements.data.count))
+            records.write(operation.type.tag)
+            operation.encode(to: &records)
+            measurements.write(durations: operation.measurements.durations)
+        }
+        
+        let measurementsOffset = headerSize + records.data.count
+        let tableOffset = measurementsOffset + measurements.data.count
+        
+        var snapshot = APDUSnapshotWriter()
+        snapshot.data.reserveCapacity(tableOffset + offsets.count * 16)
+        snapshot.data.append(contentsOf: magic)
+        snapshot.data.appendLittleEndian(version)
+        snapshot.data.appendLittleEndian(UInt16(0))
+        snapshot.write(deviceIdentifier)
+        snapshot.data.appendLittleEndian(UInt64(operations.count))
+        snapshot.data.appendLittleEndian(UInt64(tableOffset))
+        snapshot.data.append(records.data)
+        snapshot.data.append(measurements.data)
+        
+        for offset in offsets {
+            snapshot.data.appendLittleEndian(UInt64(headerSize + offset.record))
+            snapshot.data.appendLittleEndian(UInt64(measurementsOffset + offset.measurements))
+        }
+        
+        return snapshot.data
+    }
+}
+
+/**
+ A binary snapshot opened for reading.
+ 
+ Only the header is validated when opening, operations and their measurements are decoded one at a time when asked for, e.g. to compute statistics without materializing the operations.
+ */
+final class APDUSnapshotArchive {
+    typealias Format = APDUSnapshotFormat
+    
+    let deviceIdentifier: UUID
+    let count: Int
+    
+    private let contents: Data
+    private let tableOffset: Int
+    
+    init(data: Data) throws {
+        guard Format.isSnapshot(data) else {
+            throw Format.CorruptedSnapshotError(reason: "not a binary snapshot")
+        }
+        
+        self.contents = data
+        
+        var reader = APDUSnapshotReader(data: data, offset: 4, limit: Format.headerSize)
+        let version = try reader.read(UInt16.self)
+        
+        guard version == Format.version else {
+            throw Format.CorruptedSnapshotError(reason: "unsupported version \(version)")
+        }
+        
+        _ = try reader.read(UInt16.self)
+        self.deviceIdentifier = try reader.readUUID()
+        
+        // snapshots are restored on launch, a damaged one has to throw rather than trap
+        guard let count = Int(exactly: try reader.read(UInt64.self)),
+              let tableOffset = Int(exactly: try reader.read(UInt64.self)) else {
+            throw Format.CorruptedSnapshotError(reason: "invalid header")
+        }
+        
+        let tableSize = count.multipliedReportingOverflow(by: 16)
+        let tableEnd = tableOffset.addingReportingOverflow(tableSize.partialValue)
+        
+        guard tableOffset >= Format.headerSize, !tableSize.overflow, !tableEnd.overflow, tableEnd.partialValue == data.count else {
+            throw Format.CorruptedSnapshotError(reason: "invalid header")
+        }
+        
+        self.count = count
+        self.tableOffset = tableOffset
+    }
+    
+    /// Decodes the operation at `index` together with its measurements.
+    func operation(at index: Int) throws -> APDUBaseOperation {
+        let offsets = try self.offsets(at: index)
+        var reader = APDUSnapshotReader(data: contents, offset: offsets.record, limit: offsets.measurements)
+        
+        let tag = try reader.read(UInt8.self)
+        let operation: APDUBaseOperation
+        
+        switch APDUOperationType(tag: tag) {
+        case .apduTest:
+            operation = try APDUTestOperation(from: &reader)
+        case .setProtocol:
+            operation = try APDUSetProtocolOperation(from: &reader)
+        case .selectATR:
+            operation = try APDUSelectATROperation(from: &reader)
+        case .transaction:
+            operation = try APDUTransactionOperation(from: &reader)
+        case .fixture:
+            operation = try APDUFixtureOperation(from: &reader)
+        case .none:
+            throw Format.CorruptedSnapshotError(reason: "unknown operation type \(tag)")
+        }
+        
+        operation.measurements = APDUMeasurement(operationID: operation.id, durations: try durations(at: index))
+        return operation
+    }
+    
+    /// Decodes only the durations of the operation at `index`.
+    func durations(at index: Int) throws -> [MeasurementNanoseconds] {
+        let offsets = try self.offsets(at: index)
+        let limit = index + 1 < count ? try self.offsets(at: index + 1).measurements : tableOffset
+        
+        var reader = APDUSnapshotReader(data: contents, offset: offsets.measurements, limit: limit)
+        return try reader.readDurations()
+    }
+    
+    func operations() throws -> [APDUBaseOperation] {
+        try (0..<count).map { try operation(at: $0) }
+    }
+    
+    private func offsets(at index: Int) throws -> (record: Int, measurements: Int) {
+        precondition(index >= 0 && index < count, "operation index out of range")
+        
+        var reader = APDUSnapshotReader(data: contents, offset: tableOffset + index * 16, limit: contents.count)
+        guard let record = Int(exactly: try reader.read(UInt64.self)),
+              let measurements = Int(exactly: try reader.read(UInt64.self)),
+              Format.headerSize <= record, record <= measurements, measurements <= tableOffset else {
+            throw Format.CorruptedSnapshotError(reason: "invalid offsets of operation \(index)")
+        }
+        
+        return (record, measurements)
+    }
+}
+
+struct APDUSnapshotWriter {
+    var data = Data()
+    
+    mutating func write<T: FixedWidthInteger>(_ value: T) {
+        data.appendLittleEndian(value)
+    }
+    
+    mutating func writeVarint(_ value: UInt64) {
+        data.appendVarint(value)
+    }
+    
+    mutating func write(_ value: UUID) {
+        Swift.withUnsafeBytes(of: value.uuid) { data.append(contentsOf: $0) }
+    }
+    
+    mutating func write(_ value: Data) {
+        writeVarint(UInt64(value.count))
+        data.append(value)
+    }
+    
+    mutating func write(_ value: Data?) {
+        write(UInt8(value == nil ? 0 : 1))
+        if let value = value {
+            write(value)
+        }
+    }
+    
+    mutating func write(_ value: String) {
+        write(Data(value.utf8))
+    }
+    
+    mutating func write(_ state: OperationState) {
+        switch state {
+        case .pending:
+            write(UInt8(0))
+        case .running:
+            write(UInt8(1))
+        case .success:
+            write(UInt8(2))
+        case .failed(let error):
+            write(UInt8(3))
+            write(error)
+        }
+    }
+    
+    mutating func write(_ error: OperationError) {
+        switch error {
+        case .invalidResponse(let expected, let actual):
+            write(UInt8(0))
+            write(expected)
+            write(actual)
+        case .explicit(let reason):
+            write(UInt8(1))
+            write(reason)
+        case .serializationError(let reason):
+            write(UInt8(2))
+            write(reason)
+        case .cancelled:
+            write(UInt8(3))
+        }
+    }
+    
+    /// Writes the durations as zigzag encoded deltas, each one relative to the previous duration.
+    mutating func write(durations: [MeasurementNanoseconds]) {
+        writeVarint(UInt64(durations.count))
+        
+        var previous: MeasurementNanoseconds = 0
+        for duration in durations {
+            let delta = Int64(bitPattern: duration &- previous)
+            writeVarint(UInt64(bitPattern: (delta << 1) ^ (delta >> 63)))
+            previous = duration
+        }
+    }
+}
+
+struct APDUSnapshotReader {
+    let data: Data
+    private(set) var offset: Int
+    let limit: Int
+    
+    init(data: Data, offset: Int, limit: Int) {
+        self.data = data
+        self.offset = offset
+        self.limit = limit
+    }
+    
+    private mutating func take(_ length: Int) throws -> Int {
+        guard length >= 0, length <= limit - offset else {
+            throw APDUSnapshotFormat.CorruptedSnapshotError(reason: "read out of bounds at \(offset)")
+        }
+        
+        defer { offset += length }
+        return offset
+    }
+    
+    mutating func read<T: FixedWidthInteger>(_ type: T.Type) throws -> T {
+        let position = try take(MemoryLayout<T>.size)
+        return data.withUnsafeBytes { $0.littleEndian(T.self, at: position) }
+    }
+    
+    mutating func readVarint() throws -> UInt64 {
+        var position = offset
+        let value = try data.withUnsafeBytes { try $0.varint(at: &position, limit: limit) }
+        offset = position
+        return value
+    }
+    
+    /// A varint length or count, which has to fit in what's left to read.
+    private mutating func readLength() throws -> Int {
+        let start = offset
+        guard let length = Int(exactly: try readVarint()), length <= limit - offset else {
+            throw APDUSnapshotFormat.CorruptedSnapshotError(reason: "invalid length at \(start)")
+        }
+        
+        return length
+    }
+    
+    mutating func readUUID() throws -> UUID {
+        let position = try take(16)
+        return data.withUnsafeBytes { UUID(uuid: $0.loadUnaligned(fromByteOffset: position, as: uuid_t.self)) }
+    }
+    
+    mutating func readData() throws -> Data {
+        let length = try readLength()
+        let position = try take(length)
+        return data.withUnsafeBytes { Data($0[position..<position + length]) }
+    }
+    
+    mutating func readOptionalData() throws -> Data? {
+        try read(UInt8.self) == 0 ? nil : readData()
+    }
+    
+    mutating func readString() throws -> String {
+        let length = try readLength()
+        let position = try take(length)
+        return data.withUnsafeBytes { String(decoding: $0[position..<position + length], as: UTF8.self) }
+    }
+    
+    mutating func readState() throws -> OperationState {
+        switch try read(UInt8.self) {
+        case 0: return .pending
+        case 1: return .running
+        case 2: return .success
+        case 3: return .failed(try readError())
+        case let tag: throw APDUSnapshotFormat.CorruptedSnapshotError(reason: "unknown state \(tag)")
+        }
+    }
+    
+    mutating func readError() throws -> OperationError {
+        switch try read(UInt8.self) {
+        case 0: return .invalidResponse(try readData(), try readData())
+        case 1: return .explicit(try readString())
+        case 2: return .serializationError(try readString())
+        case 3: return .cancelled
+        case let tag: throw APDUSnapshotFormat.CorruptedSnapshotError(reason: "unknown error \(tag)")
+        }
+    }
+    
+    mutating func readDurations() throws -> [MeasurementNanoseconds] {
+        // every duration takes at least one byte, don't trust a count larger than that
+        let count = try readLength()
+        
+        var durations: [MeasurementNanoseconds] = []
+        durations.reserveCapacity(count)
+        
+        var previous: MeasurementNanoseconds = 0
+        for _ in 0..<count {
+            let zigzag = try readVarint()
+            let delta = Int64(bitPattern: zigzag >> 1) ^ -Int64(bitPattern: zigzag & 1)
+            previous = previous &+ MeasurementNanoseconds(bitPattern: delta)
+            durations.append(previous)
+        }
+        
+        return durations
+    }
+}
+
+extension APDUOperationType {
+    /// Stable tag of the type in binary snapshots.
+    var tag: UInt8 {
+        switch self {
+        case .apduTest: return 0
+        case .setProtocol: return 1
+        case .selectATR: return 2
+        case .transaction: return 3
+        case .fixture: return 4
+        }
+    }
+    
+    init?(tag: UInt8) {
+        switch tag {
+        case 0: self = .apduTest
+        case 1: self = .setProtocol
+        case 2: self = .selectATR
+        case 3: self = .transaction
+        case 4: self = .fixture
+        default: return nil
+        }
+    }
+}
@@ -9,18 +9,245 @@
 import Foundation
 import AirIDDriver
 
+/**
+ Keeps the last snapshot of every device across launches.
+ 
+ Snapshots are binary snapshots (`APDUSnapshotFormat`) appended to a log file, a newer snapshot of a device shadows the older ones. Only the index of the log is resident, snapshots read back are cached up to `memoryBudget` bytes and the least recently used ones are evicted first. Once most of the log is shadowed, it is compacted in the background.
+ 
+ ```
+ record   deviceIdentifier: 16 bytes | length: UInt64 | snapshot bytes
+ ```
+ */
 actor APDUSourceSnapshotStore {
-    private(set) static var current: APDUSourceSnapshotStore = .init()
+    private(set) static var current: APDUSourceSnapshotStore = .init(fileURL: defaultFileURL)
     
-    private var contents: [UUID: APDUTestSourceProtocol] = [:]
+    static let defaultMemoryBudget = 16 * 1024 * 1024
+    static let compactionThreshold = 1024 * 1024
     
-    init() { }
+    static var defaultFileURL: URL {
+        let directory = FileManager.default.urls(for: .applicationSupportDirectory, in: .userDomainMask).first
+            ?? FileManager.default.temporaryDirectory
+        return directory.appendingPathComponent("Snapshots").appendingPathComponent("snapshots.log")
+    }
+    
+    private struct Entry {
+        let offset: UInt64
+        let length: Int
+    }
+    
+    private static let recordHeaderSize = 24
     
-    func store(snapshot: APDUTestSourceProtocol, for deviceIdentifier: UUID) {
-        self.contents[deviceIdentifier] = snapshot
+    let fileURL: URL
+    let memoryBudget: Int
+    
+    private var handle: FileHandle?
+    private var index: [UUID: Entry] = [:]
+    private var fileSize: UInt64 = 0
+    private var liveBytes: UInt64 = 0
+    private var isCompactionScheduled = false
+    
+    private var cache: [UUID: Data] = [:]
+    private var cachedBytes = 0
+    /// Identifiers of `cache`, least recently used first.
+    private var recentlyUsed: [UUID] = []
+    
+    init(fileURL: URL, memoryBudget: Int = APDUSourceSnapshotStore.defaultMemoryBudget) {
+        self.fileURL = fileURL
+        self.memoryBudget = memoryBudget
+    }
+    
+    deinit {
+        try? handle?.close()
+    }
+    
+    /// Appends the binary snapshot `data` to the log, it replaces the previous snapshot of the device.
+    func store(snapshotData data: Data, for deviceIdentifier: UUID) throws {
+        let handle = try openIfNeeded()
+        
+        var record = APDUSnapshotWriter()
+        record.data.reserveCapacity(Self.recordHeaderSize + data.count)
+        record.write(deviceIdentifier)
+        record.write(UInt64(data.count))
+        record.data.append(data)
+        
+        let offset = try handle.seekToEnd()
+        do {
+            try handle.write(contentsOf: record.data)
+        } catch {
+            // a torn record would be read as the header of the next one, dropping every snapshot appended after it
+            try? handle.truncate(atOffset: offset)
+            throw error
+        }
+        
+        if let previous = index[deviceIdentifier] {
+            liveBytes -= UInt64(Self.recordHeaderSize + previous.length)
+        }
+        
+        index[deviceIdentifier] = Entry(offset: offset + UInt64(Self.recordHeaderSize), length: data.count)
+        fileSize = offset + UInt64(record.data.count)
+        liveBytes += UInt64(record.data.count)
+        cache(data, for: deviceIdentifier)
+        
+        scheduleCompactionIfNeeded()
+    }
+    
+    func store(operations: [APDUBaseOperation], for deviceIdentifier: UUID) throws {
+        try store(snapshotData: APDUSnapshotFormat.encode(operations, deviceIdentifier: deviceIdentifier), for: deviceIdentifier)
     }
     
     func snapshot(for deviceIdentifier: UUID) -> APDUTestSourceProtocol? {
-        contents[deviceIdentifier]
+        guard let data = try? snapshotData(for: deviceIdentifier) else { return nil }
+        return APDUTestSourceSnapshot(data: data)
+    }
+    
+    func snapshotData(for deviceIdentifier: UUID) throws -> Data? {
+        if let data = cache[deviceIdentifier] {
+            touch(deviceIdentifier)
+            return data
+        }
+        
+        let handle = try openIfNeeded()
+        guard let entry = index[deviceIdentifier] else { return nil }
+        
+        try handle.seek(toOffset: entry.offset)
+        guard let data = try handle.read(upToCount: entry.length), data.count == entry.length else {
+            throw APDUSnapshotFormat.CorruptedSnapshotError(reason: "snapshot log is truncated")
+        }
+        
+        cache(data, for: deviceIdentifier)
+        return data
+    }
+    
+    // MARK: - Log
+    
+    private func openIfNeeded() throws -> FileHandle {
+        if let handle = handle {
+            return handle
+        }
+        
+        let manager = FileManager.default
+        try manager.createDirectory(at: fileURL.deletingLastPathComponent(), withIntermediateDirectories: true)
+        if !manager.fileExists(atPath: fileURL.path) {
+            manager.createFile(atPath: fileURL.path, contents: nil)
+        }
+        
+        let handle = try FileHandle(forUpdating: fileURL)
+        self.handle = handle
+        try rebuildIndex(of: handle)
+        
+        return handle
+    }
+    
+    /// Reads the record headers of the log, a record torn by a crash while appending is cut off.
+    private func rebuildIndex(of handle: FileHandle) throws {
+        let contents = try Data(contentsOf: fileURL, options: .alwaysMapped)
+        index.removeAll()
+        liveBytes = 0
+        
+        var offset = 0
+        while offset + Self.recordHeaderSize <= contents.count {
+            var reader = APDUSnapshotReader(data: contents, offset: offset, limit: contents.count)
+            let deviceIdentifier = try reader.readUUID()
+            let recordLength = try reader.read(UInt64.self)
+            
+            guard recordLength <= UInt64(contents.count - reader.offset) else { break }
+            let length = Int(recordLength)
+            
+            if let previous = index[deviceIdentifier] {
+                liveBytes -= UInt64(Self.recordHeaderSize + previous.length)
+            }
+            
+            index[deviceIdentifier] = Entry(offset: UInt64(reader.offset), length: length)
+            liveBytes += UInt64(Self.recordHeaderSize + length)
+            offset = reader.offset + length
+        }
+        
+        if offset < contents.count {
+            try handle.truncate(atOffset: UInt64(offset))
+        }
+        
+        fileSize = UInt64(offset)
+    }
+    
+    private func scheduleCompactionIfNeeded() {
+        guard !isCompactionScheduled,
+              fileSize >= Self.compactionThreshold,
+              fileSize - liveBytes > liveBytes else {
+            return
+        }
+        
+        isCompactionScheduled = true
+        Task(priority: .background) {
+            try? await self.compact()
+        }
+    }
+    
+    /// Rewrites the log with only the latest snapshot of every device.
+    func compact() throws {
+        defer { isCompactionScheduled = false }
+        
+        let handle = try openIfNeeded()
+        let compactedURL = fileURL.appendingPathExtension("compacting")
+        FileManager.default.createFile(atPath: compactedURL.path, contents: nil)
+        
+        let compacted = try FileHandle(forWritingTo: compactedURL)
+        var newIndex: [UUID: Entry] = [:]
+        var offset: UInt64 = 0
+        
+        do {
+            for (deviceIdentifier, entry) in index {
+                try handle.seek(toOffset: entry.offset)
+                guard let data = try handle.read(upToCount: entry.length), data.count == entry.length else {
+                    throw APDUSnapshotFormat.CorruptedSnapshotError(reason: "snapshot log is truncated")
+                }
+                
+                var record = APDUSnapshotWriter()
+                record.write(deviceIdentifier)
+                record.write(UInt64(data.count))
+                record.data.append(data)
+                try compacted.write(contentsOf: record.data)
+                
+                newIndex[deviceIdentifier] = Entry(offset: offset + UInt64(Self.recordHeaderSize), length: entry.length)
+                offset += UInt64(record.data.count)
+            }
+            
+            try compacted.synchronize()
+            try compacted.close()
+        } catch {
+            try? compacted.close()
+            try? FileManager.default.removeItem(at: compactedURL)
+            throw error
+        }
+        
+        try handle.close()
+        self.handle = nil
+        _ = try FileManager.default.replaceItemAt(fileURL, withItemAt: compactedURL)
+        
+        self.handle = try FileHandle(forUpdating: fileURL)
+        self.index = newIndex
+        self.fileSize = offset
+        self.liveBytes = offset
+    }
+    
+    // MARK: - Cache
+    
+    private func cache(_ data: Data, for deviceIdentifier: UUID) {
+        if let previous = cache.updateValue(data, forKey: deviceIdentifier) {
+            cachedBytes -= previous.count
+        }
+        
+        cachedBytes += data.count
+        touch(deviceIdentifier)
+        
+        // the snapshot just used stays, even if it's larger than the whole budget
+        while cachedBytes > memoryBudget, recentlyUsed.count > 1 {
+            let evicted = recentlyUsed.removeFirst()
+            cachedBytes -= cache.removeValue(forKey: evicted)?.count ?? 0
+        }
+    }
+    
+    private func touch(_ deviceIdentifier: UUID) {
+        recentlyUsed.removeAll { $0 == deviceIdentifier }
+        recentlyUsed.append(deviceIdentifier)
     }
 }
@@ -0,0 +1,390 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUTestOperationStream.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Yields the operations of an APDU test file while it's being read.
+ 
+ The file is read in fixed size blocks and parsed line by line, so the first operation is available as soon as the first pair is parsed and memory stays bounded by the block size and the longest line, regardless of the script size. `REPEAT` blocks and includes are expanded as they're reached, a long endurance run only keeps the blocks being repeated in memory.
+ */
+struct APDUTestOperationStream: AsyncSequence {
+    typealias Element = APDUBaseOperation
+    
+    let device: DeviceProtocol
+    
+    private let makeReader: () -> APDUScriptFileReader
+    
+    init(fileURL: URL, device: DeviceProtocol, blockSize: Int = APDUScriptFileReader.defaultBlockSize) {
+        self.device = device
+        self.makeReader = { APDUScriptFileReader(fileURL: fileURL, blockSize: blockSize) }
+    }
+    
+    init(string: String, baseURL: URL? = nil, device: DeviceProtocol) {
+        self.device = device
+        self.makeReader = { APDUScriptFileReader(string: string, baseURL: baseURL) }
+    }
+    
+    func makeAsyncIterator() -> Iterator {
+        Iterator(reader: makeReader(), device: device, interningTable: .init())
+    }
+    
+    struct Iterator: AsyncIteratorProtocol {
+        let reader: APDUScriptFileReader
+        let device: DeviceProtocol
+        let interningTable: APDUInterningTable
+        
+        func next() async throws -> APDUBaseOperation? {
+            try Task.checkCancellation()
+            return try reader.nextEntry()?.operation(for: device, interningTable: interningTable)
+        }
+    }
+}
+
+/**
+ Synchronous pull based reader behind `APDUTestOperationStream`, also used to load a file without holding its contents in memory.
+ 
+ Directives (`APDUScriptDirective`) are expanded lazily: the lines of a `REPEAT` block are recorded once and replayed, an included script is read by a nested reader when it's reached. With `expandsDirectives` off, blocks are read once and `REPEAT`/`END` are skipped, which gives the outline of a script without its repetitions.
+ */
+final class APDUScriptFileReader {
+    static let defaultBlockSize = 64 * 1024
+    
+    private static let newline = UInt8(ascii: "\n")
+    
+    private final class BlockCursor {
+        let nodes: [APDUScriptNode]
+        var index = 0
+        var remaining: Int
+        
+        init(nodes: [APDUScriptNode], count: Int) {
+            self.nodes = nodes
+            self.remaining = count
+        }
+    }
+    
+    private enum Frame {
+        case block(BlockCursor)
+        case include(APDUScriptFileReader)
+    }
+    
+    let fileURL: URL?
+    let blockSize: Int
+    let expandsDirectives: Bool
+    
+    /// Set once a `REPEAT` has been read, here or in an included script. The outline then differs from what runs, other directives read the same either way.
+    private(set) var containsDirectives = false
+    
+    private let baseURL: URL?
+    /// Headers of an included script don't apply to the including one.
+    private let isIncluded: Bool
+    /// Scripts including this one, to refuse include cycles.
+    private let includeChain: [URL]
+    
+    private var parser: APDUScriptParser
+    private var handle: FileHandle?
+    private var buffer: [UInt8] = []
+    private var position = 0
+    private var isAtEndOfFile = false
+    private var isFinished = false
+    
+    private var ready: [APDUScriptEntry] = []
+    private var readyIndex = 0
+    private var testsCount = 0
+    
+    private var frames: [Frame] = []
+    /// `REPEAT` blocks being recorded, innermost last.
+    private var blocks: [(count: Int, nodes: [APDUScriptNode])] = []
+    private var blockParser = APDUScriptParser(expectsHeader: false)
+    /// Whether `BEGIN SETUP` was read, and its `END SETUP`.
+    private var isSetupBegun = false
+    private var isSetupEnded = false
+    
+    convenience init(fileURL: URL, blockSize: Int = APDUScriptFileReader.defaultBlockSize, expandsDirectives: Bool = true) {
+        self.init(fileURL: fileURL, baseURL: fileURL.deletingLastPathComponent(), blockSize: blockSize, expandsDirectives: expandsDirectives, isIncluded: false, includeChain: [])
+    }
+    
+    /// Reads a script held in memory, `baseURL` resolves relative includes.
+    convenience init(string: String, baseURL: URL? = nil, expandsDirectives: Bool = true) {
+        self.init(fileURL: nil, baseURL: baseURL, blockSize: Self.defaultBlockSize, expandsDirectives: expandsDirectives, isIncluded: false, includeChain: [])
+        self.buffer = Array(string.utf8)
+        self.isAtEndOfFile = true
+    }
+    
+    private init(fileURL: URL?, baseURL: URL?, blockSize: Int, expandsDirectives: Bool, isIncluded: Bool, includeChain: [URL]) {
+        self.fileURL = fileURL
+        self.baseURL = baseURL
+        self.blockSize = blockSize
+        self.expandsDirectives = expandsDirectives
+        self.isIncluded = isIncluded
+        self.includeChain = includeChain
+        self.parser = .init()
+    }
+    
+    deinit {
+        try? handle?.close()
+    }
+    
+    /// Returns the next parsed entry, or nil once the file is exhausted.
+    func nextEntry() throws -> APDUScriptEntry? {
+        while true {
+            if readyIndex < ready.count {
+                let entry = ready[readyIndex]
+                readyIndex += 1
+                
+                if isIncluded, entry.type.isHeader {
+                    continue
+                }
+                
+                return counted(entry)
+            }
+            
+            ready.removeAll(keepingCapacity: true)
+            readyIndex = 0
+            
+            if let entry = try nextExpandedEntry() {
+                return counted(entry)
+            }
+            
+            if isFinished {
+                // expansions may be empty, a script is only invalid if it ran no test at all
+                if !isIncluded, testsCount == 0 {
+                    throw APDUTestSourceString.InvalidFileError()
+                }
+                
+                return nil
+            }
+            
+            if let line = try nextLine() {
+                try consume(line: line)
+            } else {
+                isFinished = true
+                try finish()
+            }
+        }
+    }
+    
+    /// Reads the remaining entries as operations of `device`.
+    func readAll(for device: DeviceProtocol, interningTable: APDUInterningTable = .init()) throws -> [APDUBaseOperation] {
+        var operations: [APDUBaseOperation] = []
+        while let entry = try nextEntry() {
+            operations.append(entry.operation(for: device, interningTable: interningTable))
+        }
+        
+        return operations
+    }
+    
+    private func counted(_ entry: APDUScriptEntry) -> APDUScriptEntry {
+        if case .test = entry {
+            testsCount += 1
+        }
+        
+        return entry
+    }
+    
+    // MARK: - Directives
+    
+    private func consume(line: String) throws {
+        let isAwaitingResponse = blocks.isEmpty ? parser.isAwaitingResponse : blockParser.isAwaitingResponse
+        
+        if !isAwaitingResponse, let directive = APDUScriptDirective(line: line) {
+            if case .repeatBlock = directive {
+                containsDirectives = true
+            }
+            
+            // a directive ends the header like a request does
+            parser.end(into: &ready)
+            try apply(directive)
+            return
+        }
+        
+        if blocks.isEmpty {
+            parser.consume(line: line, into: &ready)
+        } else {
+            var entries: [APDUScriptEntry] = []
+            blockParser.consume(line: line, into: &entries)
+            blocks[blocks.count - 1].nodes.append(contentsOf: entries.map { .entry($0) })
+        }
+    }
+    
+    private func apply(_ directive: APDUScriptDirective) throws {
+        switch directive {
+        case .repeatBlock(let count):
+            guard expandsDirectives else { return }
+            blocks.append((count, []))
+        case .end:
+            guard expandsDirectives else { return }
+            guard let block = blocks.popLast() else {
+                throw APDUScriptDirective.InvalidDirectiveError(reason: "END without REPEAT")
+            }
+            
+            if !blocks.isEmpty {
+                blocks[blocks.count - 1].nodes.append(.repeated(count: block.count, body: block.nodes))
+            } else if block.count > 0, !block.nodes.isEmpty {
+                frames.append(.block(BlockCursor(nodes: block.nodes, count: block.count)))
+            }
+        case .include(let path):
+            let url = resolve(path)
+            
+            if blocks.isEmpty {
+                frames.append(.include(try includedReader(for: url)))
+            } else {
+                blocks[blocks.count - 1].nodes.append(.include(url))
+            }
+        case .beginTransaction:
+            append(.transaction(.begin))
+        case .endTransaction(let disposition):
+            append(.transaction(.end(disposition)))
+        case .beginSetup:
+            // the including script decides what sets the card up
+            guard !isIncluded else { return }
+            
+            // the setup has to run before anything else for the rows after it to rely on it
+            guard !isSetupBegun, blocks.isEmpty, testsCount == 0 else {
+                throw APDUScriptDirective.InvalidDirectiveError(reason: "BEGIN SETUP after the first pair")
+            }
+            
+            isSetupBegun = true
+            append(.fixture(.begin))
+        case .endSetup:
+            guard !isIncluded else { return }
+            guard isSetupBegun, !isSetupEnded, blocks.isEmpty else {
+                throw APDUScriptDirective.InvalidDirectiveError(reason: "END SETUP without BEGIN SETUP")
+            }
+            
+            isSetupEnded = true
+            append(.fixture(.end))
+        }
+    }
+    
+    /// Adds an entry made from a directive, to the block being recorded if any.
+    private func append(_ entry: APDUScriptEntry) {
+        if blocks.isEmpty {
+            ready.append(entry)
+        } else {
+            blocks[blocks.count - 1].nodes.append(.entry(entry))
+        }
+    }
+    
+    /// The next entry of the innermost block or include being expanded.
+    private func nextExpandedEntry() throws -> APDUScriptEntry? {
+        while let frame = frames.last {
+            switch frame {
+            case .include(let reader):
+                if let entry = try reader.nextEntry() {
+                    return entry
+                }
+                
+                containsDirectives = containsDirectives || reader.containsDirectives
+                frames.removeLast()
+            case .block(let cursor):
+                if cursor.index == cursor.nodes.count {
+                    cursor.index = 0
+                    cursor.remaining -= 1
+                }
+                
+                guard cursor.remaining > 0 else {
+                    frames.removeLast()
+                    continue
+                }
+                
+                let node = cursor.nodes[cursor.index]
+                cursor.index += 1
+                
+                switch node {
+                case .entry(let entry):
+                    return entry
+                case .repeated(let count, let body):
+                    if count > 0, !body.isEmpty {
+                        frames.append(.block(BlockCursor(nodes: body, count: count)))
+                    }
+                case .include(let url):
+                    frames.append(.include(try includedReader(for: url)))
+                }
+            }
+        }
+        
+        return nil
+    }
+    
+    private func resolve(_ path: String) -> URL {
+        if path.hasPrefix("/") {
+            return URL(fileURLWithPath: path)
+        }
+        
+        return (baseURL ?? URL(fileURLWithPath: FileManager.default.currentDirectoryPath)).appendingPathComponent(path)
+    }
+    
+    private func includedReader(for url: URL) throws -> APDUScriptFileReader {
+        let url = url.standardizedFileURL
+        guard url != fileURL?.standardizedFileURL, !includeChain.contains(url) else {
+            throw APDUScriptDirective.InvalidDirectiveError(reason: "\(url.lastPathComponent) includes itself")
+        }
+        
+        return APDUScriptFileReader(fileURL: url,
+                                    baseURL: url.deletingLastPathComponent(),
+                                    blockSize: blockSize,
+                                    expandsDirectives: expandsDirectives,
+                                    isIncluded: true,
+                                    includeChain: includeChain + [fileURL?.standardizedFileURL].compactMap { $0 })
+    }
+    
+    /// Flushes the header of a script without pairs, a dangling request without response is dropped.
+    private func finish() throws {
+        guard blocks.isEmpty else {
+            throw APDUScriptDirective.InvalidDirectiveError(reason: "REPEAT without END")
+        }
+        
+        guard isSetupBegun == isSetupEnded else {
+            throw APDUScriptDirective.InvalidDirectiveError(reason: "BEGIN SETUP without END SETUP")
+        }
+        
+        parser.end(into: &ready)
+    }
+    
+    // MARK: - Reading
+    
+    private func nextLine() throws -> String? {
+        while true {
+            if let end = buffer[position...].firstIndex(of: Self.newline) {
+                defer { position = end + 1 }
+                return String(decoding: buffer[position..<end], as: UTF8.self)
+            }
+            
+            if isAtEndOfFile {
+                guard position < buffer.count else { return nil }
+                defer { position = buffer.count }
+                return String(decoding: buffer[position...], as: UTF8.self)
+            }
+            
+            // keep only the unfinished line before reading the next block
+            buffer.removeSubrange(0..<position)
+            position = 0
+            try readBlock()
+        }
+    }
+    
+    private func readBlock() throws {
+        guard let fileURL = fileURL else {
+            isAtEndOfFile = true
+            return
+        }
+        
+        if handle == nil {
+            handle = try FileHandle(forReadingFrom: fileURL)
+        }
+        
+        guard let block = try handle?.read(upToCount: blockSize), !block.isEmpty else {
+            isAtEndOfFile = true
+            try? handle?.close()
+            handle = nil
+            return
+        }
+        
+        buffer.append(contentsOf: block)
+    }
+}
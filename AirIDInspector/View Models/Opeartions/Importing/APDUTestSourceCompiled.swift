@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUTestSourceCompiled.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+import AirIDDriver
+
+/**
+ A memory mapped script compiled by `APDUScriptCompiler`.
+ 
+ Opening only validates the fixed size header, records are decoded on demand. Seeking to an operation jumps to the closest index entry before it and skips at most `indexStride - 1` records.
+ */
+final class APDUCompiledScript {
+    typealias Format = APDUCompiledScriptFormat
+    
+    let fileURL: URL
+    let count: Int
+    let cardProtocol: AIPCardProtocol?
+    let atrData: Data?
+    
+    private let contents: Data
+    private let indexStride: Int
+    private let indexOffset: Int
+    private let recordsOffset: Int
+    
+    init(url: URL) throws {
+        self.fileURL = url
+        self.contents = try Data(contentsOf: url, options: .alwaysMapped)
+        
+        guard contents.count >= Format.headerSize, contents.prefix(4).elementsEqual(Format.magic) else {
+            throw Format.CorruptedFileError(reason: "not a compiled script")
+        }
+        
+        let header = contents.withUnsafeBytes { raw in
+            (version: raw.littleEndian(UInt16.self, at: 4),
+             flags: Format.Flags(rawValue: raw.littleEndian(UInt16.self, at: 6)),
+             cardProtocol: raw.littleEndian(UInt32.self, at: 8),
+             indexStride: raw.littleEndian(UInt32.self, at: 12),
+             count: raw.littleEndian(UInt64.self, at: 16),
+             indexOffset: raw.littleEndian(UInt64.self, at: 24),
+             atrLength: raw.littleEndian(UInt32.self, at: 32))
+        }
+        
+        guard header.version == Format.version else {
+            throw Format.CorruptedFileError(reason: "unsupported version \(header.version)")
+        }
+        
+        // every size is checked against the file before it's used, a damaged file throws instead of trapping
+        guard let count = Int(exactly: header.count),
+              let indexStride = Int(exactly: header.indexStride), indexStride > 0,
+              let indexOffset = Int(exactly: header.indexOffset),
+              let atrLength = Int(exactly: header.atrLength), atrLength <= contents.count - Format.headerSize else {
+            throw Format.CorruptedFileError(reason: "invalid header")
+        }
+        
+        let indexEntries = count == 0 ? 0 : (count - 1) / indexStride + 1
+        let indexSize = indexEntries.multipliedReportingOverflow(by: 8)
+        let indexEnd = indexOffset.addingReportingOverflow(indexSize.partialValue)
+        
+        self.count = count
+        self.indexStride = indexStride
+        self.indexOffset = indexOffset
+        self.recordsOffset = Format.headerSize + atrLength
+        
+        guard recordsOffset <= indexOffset, !indexSize.overflow, !indexEnd.overflow, indexEnd.partialValue <= contents.count else {
+            throw Format.CorruptedFileError(reason: "invalid header")
+        }
+        
+        self.cardProtocol = header.flags.contains(.hasProtocol) ? AIPCardProtocol(rawValue: UInt(header.cardProtocol)) : nil
+        self.atrData = header.flags.contains(.hasATR) ? Data(contents[Format.headerSize..<recordsOffset]) : nil
+    }
+    
+    /// The entries that precede the records, in the same order `APDUScriptParser` produces them.
+    var headerEntries: [APDUScriptEntry] {
+        var entries: [APDUScriptEntry] = [.selectATR(atrData)]
+        if let cardProtocol = cardProtocol {
+            entries.append(.setProtocol(cardProtocol))
+        }
+        
+        return entries
+    }
+    
+    /// Returns a cursor positioned on the record `operationIndex`.
+    func cursor(at operationIndex: Int = 0) throws -> Cursor {
+        precondition(operationIndex >= 0 && operationIndex <= count, "operation index out of range")
+        
+        guard operationIndex < count else {
+            return Cursor(script: self, index: count, offset: indexOffset)
+        }
+        
+        let entry = operationIndex / indexStride
+        let storedOffset = contents.withUnsafeBytes { raw in
+            raw.littleEndian(UInt64.self, at: indexOffset + entry * 8)
+        }
+        
+        guard let offset = Int(exactly: storedOffset), offset >= recordsOffset, offset <= indexOffset else {
+            throw Format.CorruptedFileError(reason: "index entry \(entry) is out of bounds")
+        }
+        
+        var cursor = Cursor(script: self, index: entry * indexStride, offset: offset)
+        while cursor.index < operationIndex {
+            try cursor.skip()
+        }
+        
+        return cursor
+    }
+    
+    struct Cursor {
+        let script: APDUCompiledScript
+        private(set) var index: Int
+        private(set) var offset: Int
+        
+        fileprivate init(script: APDUCompiledScript, index: Int, offset: Int) {
+            self.script = script
+            self.index = index
+            self.offset = offset
+        }
+        
+        /// Decodes the record under the cursor and moves past it, nil at the end of the script.
+        mutating func nextRecord() throws -> Record? {
+            guard index < script.count else { return nil }
+            
+            let (record, next) = try script.record(at: offset, decode: true)
+            offset = next
+            index += 1
+            return record
+        }
+        
+        mutating func next() throws -> APDUScriptEntry? {
+            try nextRecord()?.entry
+        }
+        
+        mutating func skip() throws {
+            offset = try script.record(at: offset, decode: false).next
+            index += 1
+        }
+    }
+    
+    /// A test pair with the matcher it was compiled into.
+    struct Record {
+        let command: Data
+        let matcher: APDUResponseMatcher
+        
+        var entry: APDUScriptEntry {
+            .test(command: command, expectedResponse: matcher.expectedResponse)
+        }
+        
+        func operation(for device: DeviceProtocol, interningTable: APDUInterningTable) -> APDUBaseOperation {
+            APDUTestOperation(id: interningTable.identifier(for: entry), device: device, data: command,
+                              expectedResponse: matcher.expectedResponse, matcher: matcher, interningTable: interningTable)
+        }
+    }
+    
+    private func record(at offset: Int, decode: Bool) throws -> (record: Record?, next: Int) {
+        try contents.withUnsafeBytes { raw in
+            var position = offset
+            
+            func take(_ length: UInt64) throws -> Range<Int> {
+                guard let length = Int(exactly: length), length <= indexOffset - position else {
+                    throw Format.CorruptedFileError(reason: "record at \(offset) is out of bounds")
+                }
+                
+                defer { position += length }
+                return position..<position + length
+            }
+            
+            let command = try take(raw.varint(at: &position, limit: indexOffset))
+            let response = try take(raw.varint(at: &position, limit: indexOffset))
+            
+            guard decode else {
+                try APDUResponseMatcher.skipCompiled(raw, at: &position, limit: indexOffset)
+                return (nil, position)
+            }
+            
+            let matcher = try APDUResponseMatcher(compiled: raw, at: &position, limit: indexOffset,
+                                                  expectedResponse: String(decoding: raw[response], as: UTF8.self),
+                                                  options: .defaultOptions)
+            return (Record(command: Data(raw[command]), matcher: matcher), position)
+        }
+    }
+}
+
+/**
+ Source of a compiled script, optionally restricted to a range of its operations, e.g. to resume a run.
+ 
+ The header operations (ATR, protocol) are always included, so a subrange still starts on a freshly reset card.
+ */
+class APDUTestSourceCompiled: APDUTestSourceProtocol {
+    let fileURL: URL
+    let range: Range<Int>?
+    
+    private(set) var interningReport: APDUInterningTable.Report?
+    
+    init(url: URL, range: Range<Int>? = nil) {
+        self.fileURL = url
+        self.range = range
+    }
+    
+    func getAPDUTestOperations(for device: DeviceProtocol) throws -> [APDUBaseOperation] {
+        let script = try APDUCompiledScript(url: fileURL)
+        let range = (self.range ?? 0..<script.count).clamped(to: 0..<script.count)
+        
+        let interningTable = APDUInterningTable()
+        defer { interningReport = interningTable.report }
+        
+        var operations = script.headerEntries.map { $0.operation(for: device, interningTable: interningTable) }
+        operations.reserveCapacity(operations.count + range.count)
+        
+        var cursor = try script.cursor(at: range.lowerBound)
+        while cursor.index < range.upperBound, let record = try cursor.nextRecord() {
+            operations.append(record.operation(for: device, interningTable: interningTable))
+        }
+        
+        return operations
+    }
+    
+    func loadAPDUOperationTable(for device: DeviceProtocol) async throws -> APDUOperationTable {
+        let script = try APDUCompiledScript(url: fileURL)
+        let range = (self.range ?? 0..<script.count).clamped(to: 0..<script.count)
+        
+        let table = APDUOperationTable(entries: script.headerEntries)
+        table.reserveCapacity(table.count + range.count)
+        
+        var cursor = try script.cursor(at: range.lowerBound)
+        while cursor.index < range.upperBound, let record = try cursor.nextRecord() {
+            table.append(record.entry, matcher: record.matcher)
+        }
+        
+        interningReport = table.interningReport
+        return table
+    }
+}
+
+extension UnsafeRawBufferPointer {
+    func littleEndian<T: FixedWidthInteger>(_ type: T.Type, at offset: Int) -> T {
+        T(littleEndian: loadUnaligned(fromByteOffset: offset, as: T.self))
+    }
+    
+    /// Reads a LEB128 varint at `position` and moves past it.
+    func varint(at position: inout Int, limit: Int) throws -> UInt64 {
+        var value: UInt64 = 0
+        var shift: UInt64 = 0
+        
+        while position < limit, shift < 64 {
+            let byte = self[position]
+            position += 1
+            value |= UInt64(byte & 0x7F) << shift
+            
+            if byte & 0x80 == 0 {
+                return value
+            }
+            
+            shift += 7
+        }
+        
+        throw APDUCompiledScriptFormat.CorruptedFileError(reason: "invalid varint at \(position)")
+    }
+}
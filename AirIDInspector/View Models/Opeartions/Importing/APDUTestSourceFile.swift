@@ -8,16 +8,44 @@
 
 import Foundation
 
-class APDUTestSourceFile: APDUTestSourceProtocol {
+class APDUTestSourceFile: APDUTestStreamingSourceProtocol {
     let fileURL: URL
     
+    private(set) var interningReport: APDUInterningTable.Report?
+    private(set) var containsDirectives = false
+    
     init(url: URL) {
         self.fileURL = url
     }
     
     func getAPDUTestOperations(for device: DeviceProtocol) throws -> [APDUBaseOperation] {
-        let rawString = try String(contentsOf: fileURL)
-        return try APDUTestSourceString(string: rawString)
-            .getAPDUTestOperations(for: device)
+        let interningTable = APDUInterningTable()
+        defer { interningReport = interningTable.report }
+        
+        return try APDUScriptFileReader(fileURL: fileURL).readAll(for: device, interningTable: interningTable)
+    }
+    
+    func loadAPDUOperationTable(for device: DeviceProtocol) async throws -> APDUOperationTable {
+        let table = APDUOperationTable()
+        let reader = APDUScriptFileReader(fileURL: fileURL, expandsDirectives: false)
+        
+        while let entry = try reader.nextEntry() {
+            table.append(entry)
+        }
+        
+        interningReport = table.interningReport
+        containsDirectives = reader.containsDirectives
+        return table
+    }
+    
+    /// Starts watching the file, `onChange` is called on a background queue after every edit.
+    func watch(onChange: @escaping () -> Void) -> APDUScriptFileWatcher {
+        let watcher = APDUScriptFileWatcher(fileURL: fileURL, onChange: onChange)
+        watcher.start()
+        return watcher
+    }
+    
+    func operationStream(for device: DeviceProtocol) -> APDUTestOperationStream {
+        APDUTestOperationStream(fileURL: fileURL, device: device)
     }
 }
@@ -10,4 +10,44 @@ import Foundation
 
 protocol APDUTestSourceProtocol {
     func getAPDUTestOperations(for device: DeviceProtocol) throws -> [APDUBaseOperation]
+    
+    /// Loads the operations away from the caller's actor, sources able to split the work override it.
+    func loadAPDUTestOperations(for device: DeviceProtocol) async throws -> [APDUBaseOperation]
+    
+    /// Loads the operations into a table, sources parsing a script override it to skip creating operation objects.
+    func loadAPDUOperationTable(for device: DeviceProtocol) async throws -> APDUOperationTable
+    
+    /// How much the operations of the last load share, nil for sources which don't parse a script.
+    var interningReport: APDUInterningTable.Report? { get }
+}
+
+extension APDUTestSourceProtocol {
+    var interningReport: APDUInterningTable.Report? {
+        nil
+    }
+    
+    func loadAPDUTestOperations(for device: DeviceProtocol) async throws -> [APDUBaseOperation] {
+        try getAPDUTestOperations(for: device)
+    }
+    
+    func loadAPDUOperationTable(for device: DeviceProtocol) async throws -> APDUOperationTable {
+        APDUOperationTable(operations: try await loadAPDUTestOperations(for: device))
+    }
+    
+    /// Loads the table again after the script changed, rows left unchanged keep their identity, state and measurements.
+    func reloadAPDUOperationTable(for device: DeviceProtocol, replacing previous: APDUOperationTable) async throws -> APDUOperationTable {
+        let table = try await loadAPDUOperationTable(for: device)
+        table.inheritUnchangedRows(of: previous)
+        return table
+    }
+}
+
+/**
+ A source able to hand out its operations while they're still being parsed, so a run doesn't have to wait for the whole script.
+ */
+protocol APDUTestStreamingSourceProtocol: APDUTestSourceProtocol {
+    func operationStream(for device: DeviceProtocol) -> APDUTestOperationStream
+    
+    /// Whether the last loaded script, or a script it includes, has `REPEAT` directives, its table is then only the outline of what runs.
+    var containsDirectives: Bool { get }
 }
@@ -15,6 +15,14 @@ class APDUTestSourceSnapshot: APDUTestSourceProtocol {
         case operations([APDUBaseOperation])
     }
     
+    /**
+     Encodings of a snapshot, binary is the compact one used to save and restore, JSON is kept to export and share tests.
+     */
+    enum Format {
+        case binary
+        case json
+    }
+    
     struct APDUTestContents: Codable {
         let deviceIdentifier: UUID
         let operations: [APDUOperationContainer]
@@ -34,12 +42,59 @@ class APDUTestSourceSnapshot: APDUTestSourceProtocol {
         self.source = .operations(operations)
     }
     
+    /// Encodes `operations` into data that `init(data:)` reads back, the format is detected when reading.
+    static func data(for operations: [APDUBaseOperation], deviceIdentifier: UUID, format: Format = .binary) throws -> Data {
+        switch format {
+        case .binary:
+            return APDUSnapshotFormat.encode(operations, deviceIdentifier: deviceIdentifier)
+        case .json:
+            let encoder = JSONEncoder()
+            encoder.keyEncodingStrategy = .convertToSnakeCase
+            
+            let contents = APDUTestContents(deviceIdentifier: deviceIdentifier,
+                                            operations: operations.map { APDUOperationContainer(operation: $0) })
+            return try encoder.encode(contents)
+        }
+    }
+    
     func getAPDUTestOperations(for device: DeviceProtocol) throws -> [APDUBaseOperation] {
-        return try self.contents(of: source, for: device)
+        let operations = try self.contents(of: source)
+        operations.forEach { $0.setDevice(device) }
+        return operations
+    }
+    
+    /// Binary snapshots are restored one operation at a time, only the rows of the table are kept.
+    func loadAPDUOperationTable(for device: DeviceProtocol) async throws -> APDUOperationTable {
+        guard let archive = try archive(of: source) else {
+            return APDUOperationTable(operations: try getAPDUTestOperations(for: device))
+        }
+        
+        let table = APDUOperationTable()
+        table.reserveCapacity(archive.count)
+        
+        for index in 0..<archive.count {
+            table.append(try archive.operation(at: index))
+        }
+        
+        return table
+    }
+    
+    private func archive(of source: Source) throws -> APDUSnapshotArchive? {
+        switch source {
+        case .data(let data) where APDUSnapshotFormat.isSnapshot(data):
+            return try APDUSnapshotArchive(data: data)
+        case .file(let url):
+            let data = try Data(contentsOf: url, options: .mappedIfSafe)
+            return APDUSnapshotFormat.isSnapshot(data) ? try APDUSnapshotArchive(data: data) : nil
+        case .data, .operations:
+            return nil
+        }
     }
     
-    private func contents(of source: Source, for device: DeviceProtocol) throws -> [APDUBaseOperation] {
-        switch self.source {
+    private func contents(of source: Source) throws -> [APDUBaseOperation] {
+        switch source {
+        case .data(let data) where APDUSnapshotFormat.isSnapshot(data):
+            return try APDUSnapshotArchive(data: data).operations()
         case .data(let data):
             let decoder = JSONDecoder()
             decoder.keyDecodingStrategy = .convertFromSnakeCase
@@ -48,9 +103,8 @@ class APDUTestSourceSnapshot: APDUTestSourceProtocol {
             let operations = containers.operations.map { $0.internalOperation }
             return operations
         case .file(let url):
-            return try self.contents(of: .data(try Data(contentsOf: url)), for: device)
+            return try self.contents(of: .data(try Data(contentsOf: url, options: .mappedIfSafe)))
         case .operations(let operations):
-            operations.forEach { $0.setDevice(device) }
             return operations
         }
     }
@@ -9,68 +9,94 @@
 import Foundation
 import AirIDDriver
 
-class APDUTestSourceString: APDUTestSourceProtocol {
+class APDUTestSourceString: APDUTestStreamingSourceProtocol {
     struct InvalidFileError: LocalizedError {
         var errorDescription: String? {
             "File is invalid"
         }
     }
     
+    enum ParsingMode {
+        case sequential
+        case parallel
+        /// parallel once the script is large enough to amortize the chunking
+        case automatic
+    }
+    
+    static let parallelParsingThreshold = 1 << 20
+    
     let rawString: String
+    let parsingMode: ParsingMode
+    /// Where relative includes of the script are looked up.
+    let baseURL: URL?
+    
+    private(set) var interningReport: APDUInterningTable.Report?
+    private(set) var containsDirectives = false
     
-    init(string: String) {
+    init(string: String, parsingMode: ParsingMode = .automatic, baseURL: URL? = nil) {
         self.rawString = string
+        self.parsingMode = parsingMode
+        self.baseURL = baseURL
     }
     
     func getAPDUTestOperations(for device: DeviceProtocol) throws -> [APDUBaseOperation] {
-        var lines = rawString.components(separatedBy: .newlines)
-        var operations: [APDUBaseOperation] = []
+        let interningTable = APDUInterningTable()
+        defer { interningReport = interningTable.report }
         
-        if let firstLine = lines.first, firstLine.starts(with: "T=") {
-            let protocolType = String(firstLine.dropFirst(2))
-            var cardProtocol: AIPCardProtocol
-            
-            switch protocolType {
-            case "1": cardProtocol = .T1
-            case "0": cardProtocol = .T0
-            default: cardProtocol = .tx
-            }
-            
+        return try APDUScriptFileReader(string: rawString, baseURL: baseURL).readAll(for: device, interningTable: interningTable)
+    }
+    
+    func loadAPDUTestOperations(for device: DeviceProtocol) async throws -> [APDUBaseOperation] {
+        switch parsingMode {
+        case .sequential:
+            return try getAPDUTestOperations(for: device)
+        case .automatic where rawString.utf8.count < Self.parallelParsingThreshold:
+            return try getAPDUTestOperations(for: device)
+        case _ where APDUScriptDirective.containsDirectives(in: rawString):
+            // chunks can't be parsed independently across blocks
+            return try getAPDUTestOperations(for: device)
+        case .parallel, .automatic:
+            let interningTable = APDUInterningTable()
+            defer { interningReport = interningTable.report }
             
-            operations.append(APDUSetProtocolOperation(device: device, name: "Set Protocol..", protocol: cardProtocol))
-            lines.removeFirst()
+            return try await APDUParallelScriptParser.operations(in: rawString, for: device, interningTable: interningTable)
         }
+    }
+    
+    func loadAPDUOperationTable(for device: DeviceProtocol) async throws -> APDUOperationTable {
+        containsDirectives = APDUScriptDirective.containsDirectives(in: rawString)
         
-        if let firstLine = lines.first, firstLine.starts(with: "ATR:") {
-            let ATR = String(firstLine.dropFirst(4)).hexadecimal
-            if let atrData = ATR {
-                operations.insert(APDUSelectATROperation(device: device, name: "Select ATR..", atrData: atrData), at: 0)
-            }
+        switch parsingMode {
+        case .sequential:
+            break
+        case .automatic where rawString.utf8.count < Self.parallelParsingThreshold:
+            break
+        case _ where containsDirectives:
+            break
+        case .parallel, .automatic:
+            // entries go straight into the columns, no operation is created for a large script
+            let entries = try await APDUParallelScriptParser.entries(in: rawString)
+            let table = APDUOperationTable()
+            table.reserveCapacity(entries.count)
+            entries.forEach { table.append($0) }
             
-            lines.removeFirst()
-        } else {
-            // manually append the select ATR operation
-            operations.insert(APDUSelectATROperation(device: device, name: "Selecting ATR..", atrData: nil), at: 0)
-        }
-        
-        let chunks = stride(from: 0, to: lines.count, by: 2).map {
-            Array(lines[$0 ..< Swift.min($0 + 2, lines.count)])
-        }
-        
-        if chunks.isEmpty {
-            throw InvalidFileError()
+            interningReport = table.interningReport
+            return table
         }
         
+        let table = APDUOperationTable()
+        let reader = APDUScriptFileReader(string: rawString, baseURL: baseURL, expandsDirectives: false)
         
-        for chunk in chunks {
-            if let data = chunk.first?.hexadecimal, let response = chunk.last {
-                let newOperation = APDUTestOperation(device: device,
-                                                     data: data,
-                                                     expectedResponse: response)
-                operations.append(newOperation)
-            }
+        while let entry = try reader.nextEntry() {
+            table.append(entry)
         }
         
-        return operations
+        interningReport = table.interningReport
+        containsDirectives = reader.containsDirectives
+        return table
+    }
+    
+    func operationStream(for device: DeviceProtocol) -> APDUTestOperationStream {
+        APDUTestOperationStream(string: rawString, baseURL: baseURL, device: device)
     }
 }
@@ -19,22 +19,21 @@ extension String {
     /// - returns: Data represented by this hexadecimal string.
     
     var hexadecimal: Data? {
-        var data = Data(capacity: count / 2)
-        
-        let regex = try! NSRegularExpression(pattern: "[0-9a-f]{1,2}", options: .caseInsensitive)
-        regex.enumerateMatches(in: self, range: NSRange(startIndex..., in: self)) { match, _, _ in
-            let byteString = (self as NSString).substring(with: match!.range)
-            let num = UInt8(byteString, radix: 16)!
-            data.append(num)
-        }
-        
-        guard data.count > 0 else { return nil }
-        
-        return data
+        var string = self
+        return string.withUTF8 { HexCodec.decode($0) }
     }
     
 }
 
+extension Substring {
+    
+    /// Same as `String.hexadecimal`, without copying the substring out first.
+    var hexadecimal: Data? {
+        var string = self
+        return string.withUTF8 { HexCodec.decode($0) }
+    }
+}
+
 extension StringProtocol {
     var asciiValues: [UInt8] {
         return compactMap { $0.asciiValue }
@@ -61,7 +60,161 @@ extension Data {
     }
 
     func hexEncodedString(options: HexEncodingOptions = [.upperCase]) -> String {
-        let format = options.contains(.upperCase) ? "%02hhX" : "%02hhx"
-        return self.map { String(format: format, $0) }.joined()
+        self.withUnsafeBytes { HexCodec.encode($0, upperCase: options.contains(.upperCase)) }
+    }
+}
+
+/**
+ Table driven hex encoding / decoding working directly on UTF8 bytes.
+ 
+ Both directions write into preallocated storage, and take a 16 byte SIMD path whenever the input allows it. Decoding keeps the tolerant semantics of the old regex (`[0-9a-f]{1,2}`, case insensitive): every run of hex digits is consumed in pairs, a trailing odd digit becomes a byte of its own, and anything else is skipped.
+ */
+enum HexCodec {
+    private static let invalid: UInt8 = 0xFF
+    
+    /// Maps an ASCII byte to its nibble value, or `invalid`.
+    private static let nibbles: [UInt8] = (0...255).map { byte -> UInt8 in
+        switch UInt8(byte) {
+        case UInt8(ascii: "0")...UInt8(ascii: "9"): return UInt8(byte) - UInt8(ascii: "0")
+        case UInt8(ascii: "a")...UInt8(ascii: "f"): return UInt8(byte) - UInt8(ascii: "a") + 10
+        case UInt8(ascii: "A")...UInt8(ascii: "F"): return UInt8(byte) - UInt8(ascii: "A") + 10
+        default: return invalid
+        }
+    }
+    
+    private static let upperDigits: [UInt8] = Array("0123456789ABCDEF".utf8)
+    private static let lowerDigits: [UInt8] = Array("0123456789abcdef".utf8)
+    
+    /// Upper bound of decoded bytes for `count` input characters ("A B C" decodes to 3 bytes).
+    static func maximumDecodedCount(for count: Int) -> Int {
+        (count + 1) / 2
+    }
+    
+    static func decode(_ utf8: UnsafeBufferPointer<UInt8>) -> Data? {
+        guard !utf8.isEmpty else { return nil }
+        
+        var data = Data(count: maximumDecodedCount(for: utf8.count))
+        let written = data.withUnsafeMutableBytes { raw in
+            decode(utf8, into: raw.bindMemory(to: UInt8.self))
+        }
+        
+        guard written > 0 else { return nil }
+        
+        data.count = written
+        return data
+    }
+    
+    /**
+     Decodes `utf8` into `output`, which must hold at least `maximumDecodedCount(for: utf8.count)` bytes.
+     
+     - returns: the number of bytes written.
+     */
+    static func decode(_ utf8: UnsafeBufferPointer<UInt8>, into output: UnsafeMutableBufferPointer<UInt8>) -> Int {
+        guard let input = utf8.baseAddress, let out = output.baseAddress else { return 0 }
+        
+        let count = utf8.count
+        var index = 0
+        var written = 0
+        var pending: UInt8 = invalid
+        
+        return nibbles.withUnsafeBufferPointer { table in
+            while index < count {
+                // fast path: 16 hex characters on a pair boundary become 8 bytes at once
+                if pending == invalid, count - index >= 16 {
+                    let chars = UnsafeRawPointer(input + index).loadUnaligned(as: SIMD16<UInt8>.self)
+                    if let bytes = decodeBlock(chars) {
+                        UnsafeMutableRawPointer(out + written).storeBytes(of: bytes, as: SIMD8<UInt8>.self)
+                        written += 8
+                        index += 16
+                        continue
+                    }
+                }
+                
+                let nibble = table[Int(input[index])]
+                index += 1
+                
+                if nibble == invalid {
+                    if pending != invalid {
+                        out[written] = pending
+                        written += 1
+                        pending = invalid
+                    }
+                } else if pending == invalid {
+                    pending = nibble
+                } else {
+                    out[written] = pending << 4 | nibble
+                    written += 1
+                    pending = invalid
+                }
+            }
+            
+            if pending != invalid {
+                out[written] = pending
+                written += 1
+            }
+            
+            return written
+        }
+    }
+    
+    /// Decodes 16 hex characters into 8 bytes, or returns nil if any of them isn't a hex digit.
+    @inline(__always)
+    private static func decodeBlock(_ chars: SIMD16<UInt8>) -> SIMD8<UInt8>? {
+        let lower = chars | 0x20
+        let isDigit = (chars .>= 0x30) .& (chars .<= 0x39)
+        let isLetter = (lower .>= 0x61) .& (lower .<= 0x66)
+        
+        guard all(isDigit .| isLetter) else { return nil }
+        
+        // '0'...'9' -> 0...9, 'a'...'f' / 'A'...'F' -> 1...6 + 9
+        let values = (chars & 0x0F) &+ ((chars &>> 6) &* 9)
+        return (values.evenHalf &<< 4) | values.oddHalf
+    }
+    
+    static func encode(_ bytes: UnsafeRawBufferPointer, upperCase: Bool = true) -> String {
+        guard !bytes.isEmpty else { return "" }
+        
+        return String(unsafeUninitializedCapacity: bytes.count * 2) { output in
+            encode(bytes, into: output, upperCase: upperCase)
+        }
+    }
+    
+    /**
+     Encodes `bytes` into `output`, which must hold at least `bytes.count * 2` bytes.
+     
+     - returns: the number of characters written.
+     */
+    @discardableResult
+    static func encode(_ bytes: UnsafeRawBufferPointer, into output: UnsafeMutableBufferPointer<UInt8>, upperCase: Bool = true) -> Int {
+        guard let input = bytes.baseAddress, let out = output.baseAddress else { return 0 }
+        
+        let count = bytes.count
+        let letterOffset: UInt8 = upperCase ? 7 : 39 // distance from '9' + 1 to 'A' / 'a'
+        var index = 0
+        
+        // fast path: 8 bytes become 16 characters at once
+        while count - index >= 8 {
+            let values = input.loadUnaligned(fromByteOffset: index, as: SIMD8<UInt8>.self)
+            var nibbles = SIMD16<UInt8>()
+            nibbles.evenHalf = values &>> 4
+            nibbles.oddHalf = values & 0x0F
+            
+            var chars = nibbles &+ 0x30
+            chars.replace(with: chars &+ letterOffset, where: nibbles .> 9)
+            
+            UnsafeMutableRawPointer(out + index * 2).storeBytes(of: chars, as: SIMD16<UInt8>.self)
+            index += 8
+        }
+        
+        (upperCase ? upperDigits : lowerDigits).withUnsafeBufferPointer { digits in
+            while index < count {
+                let byte = input.load(fromByteOffset: index, as: UInt8.self)
+                out[index * 2] = digits[Int(byte >> 4)]
+                out[index * 2 + 1] = digits[Int(byte & 0x0F)]
+                index += 1
+            }
+        }
+        
+        return count * 2
     }
 }
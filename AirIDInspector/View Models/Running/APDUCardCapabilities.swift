@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUCardCapabilities.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ What a card declares it supports in the historical bytes of its ATR, ISO 7816-4 card capabilities (compact-TLV tag 7).
+ */
+struct APDUCardCapabilities: Equatable {
+    /// Whether the card takes extended Lc and Le fields.
+    let supportsExtendedLength: Bool
+    
+    init(supportsExtendedLength: Bool) {
+        self.supportsExtendedLength = supportsExtendedLength
+    }
+    
+    /// A card which doesn't declare its capabilities gets none.
+    init(atr: Data) {
+        let capabilities = Self.historicalObjects(of: [UInt8](atr))[0x7] ?? []
+        supportsExtendedLength = capabilities.count >= 3 && capabilities[2] & 0x40 != 0
+    }
+    
+    /// The compact-TLV objects of the historical bytes by tag.
+    private static func historicalObjects(of atr: [UInt8]) -> [UInt8: [UInt8]] {
+        guard atr.count >= 2 else { return [:] }
+        
+        // TS T0, then TA TB TC TD as announced by the high nibble of T0 and of every TD
+        var index = 2
+        var indicator = atr[1] >> 4
+        while true {
+            index += (0..<3).filter { indicator & (1 << $0) != 0 }.count
+            guard indicator & 0x8 != 0, index < atr.count else { break }
+            
+            indicator = atr[index] >> 4
+            index += 1
+        }
+        
+        let historicalCount = Int(atr[1] & 0x0F)
+        guard index < atr.count else { return [:] }
+        let historical = Array(atr[index..<min(index + historicalCount, atr.count)])
+        
+        // 80 is followed by objects only, 00 leaves 3 status bytes at the end
+        var objects: ArraySlice<UInt8>
+        switch historical.first {
+        case 0x80:
+            objects = historical.dropFirst()
+        case 0x00 where historical.count >= 4:
+            objects = historical.dropFirst().dropLast(3)
+        default:
+            return [:]
+        }
+        
+        var result: [UInt8: [UInt8]] = [:]
+        while let header = objects.first {
+            let length = Int(header & 0x0F)
+            objects = objects.dropFirst()
+            guard objects.count >= length else { break }
+            
+            result[header >> 4] = Array(objects.prefix(length))
+            objects = objects.dropFirst(length)
+        }
+        
+        return result
+    }
+}
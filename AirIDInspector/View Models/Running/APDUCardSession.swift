@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUCardSession.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+import AirIDDriver
+
+/**
+ How the powered card of a device was last set up, so a warm run can skip the header rows which wouldn't change anything, and a setup block nothing undid since it ran.
+ */
+struct APDUCardSession: Equatable {
+    /// The ATR the card answered its last reset with.
+    private(set) var atr: Data?
+    /// The protocol selected since that reset, nil for the one the card negotiated.
+    private(set) var cardProtocol: AIPCardProtocol?
+    /// Ids of the setup rows which ran since, nil once the card was reset.
+    private(set) var fixture: [UUID]?
+    
+    init() { }
+    
+    /// Whether header `row` of `table` would leave the card as it already is.
+    func isRedundant(_ row: Int, of table: APDUOperationTable) -> Bool {
+        switch table.type(at: row) {
+        case .selectATR:
+            guard let atr = atr else { return false }
+            return table.expectedATR(at: row).map { $0 == atr } ?? true
+        case .setProtocol:
+            return cardProtocol != nil && cardProtocol == table.cardProtocol(at: row)
+        case .apduTest, .transaction, .fixture:
+            return false
+        }
+    }
+    
+    /// Whether the setup rows of `table` ran on the card as it is, comparing ids tells an edited setup apart.
+    func isFixtureEstablished(in table: APDUOperationTable) -> Bool {
+        guard let fixture = fixture, let rows = table.fixtureRows else { return false }
+        return fixture == rows.map(table.identifier(at:))
+    }
+    
+    /// Follows header `row` of `table` once it ran.
+    mutating func apply(_ row: Int, of table: APDUOperationTable) {
+        switch table.type(at: row) {
+        case .selectATR:
+            // a reset drops the selected protocol
+            atr = table.responseATR(at: row)
+            cardProtocol = nil
+            fixture = nil
+        case .setProtocol:
+            cardProtocol = table.cardProtocol(at: row)
+            fixture = nil
+        case .transaction:
+            // resetting or powering the card down at the end loses how it was set up
+            if case .end(let disposition) = table.transactionBoundary(at: row), disposition != .leave {
+                atr = nil
+                cardProtocol = nil
+                fixture = nil
+            }
+        case .fixture:
+            if let rows = table.fixtureRows, row == rows.upperBound - 1 {
+                fixture = rows.map(table.identifier(at:))
+            }
+        case .apduTest:
+            break
+        }
+    }
+}
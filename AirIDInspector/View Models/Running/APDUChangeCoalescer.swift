@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUChangeCoalescer.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Folds many changes into at most one publication per interval, one display refresh by default.
+ 
+ A change after a quiet period is published on the next turn of the main queue, changes following it within the interval wait for the end of the interval and are published together. Can be told about changes from any thread, publications always happen on the main queue.
+ */
+final class APDUChangeCoalescer {
+    /// 60 publications per second.
+    static let defaultInterval: UInt64 = 16_666_667
+    
+    let interval: UInt64
+    
+    private let publish: () -> Void
+    private let lock = NSLock()
+    private var isScheduled = false
+    private var publishedAt: UInt64 = 0
+    
+    init(interval: UInt64 = APDUChangeCoalescer.defaultInterval, publish: @escaping () -> Void) {
+        self.interval = interval
+        self.publish = publish
+    }
+    
+    func setNeedsPublish() {
+        lock.lock()
+        defer { lock.unlock() }
+        
+        guard !isScheduled else { return }
+        isScheduled = true
+        
+        let elapsed = DispatchTime.now().uptimeNanoseconds - publishedAt
+        let delay = elapsed >= interval ? 0 : interval - elapsed
+        
+        DispatchQueue.main.asyncAfter(deadline: .now() + .nanoseconds(Int(delay))) { [weak self] in
+            self?.flush()
+        }
+    }
+    
+    private func flush() {
+        lock.lock()
+        isScheduled = false
+        publishedAt = DispatchTime.now().uptimeNanoseconds
+        lock.unlock()
+        
+        publish()
+    }
+}
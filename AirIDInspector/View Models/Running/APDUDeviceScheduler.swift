@@ -0,0 +1,255 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUDeviceScheduler.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Hands the card of a device to one job at a time, so runs started from different places don't interleave their APDUs.
+ 
+ Waiting jobs start by priority, then in the order they were submitted. The queue is bounded: once `capacity` jobs wait, `submit` suspends the producer until one of them starts or is cancelled. Interactive jobs are never held back, they come one tap at a time.
+ 
+ Cancelling a job which waits takes it out of the queue, cancelling a running job cancels its task, which the device calls check. A cancelled job keeps the card until its work returns, the device calls only return once the round trip on the link is over, so the next job never talks to a card still answering.
+ */
+actor APDUDeviceScheduler {
+    enum Priority: Int, Comparable, CaseIterable, CustomStringConvertible {
+        /// battery reads, status polls, anything which can wait
+        case housekeeping
+        /// test runs
+        case background
+        /// a single APDU sent from the UI
+        case interactive
+        
+        static func < (lhs: Priority, rhs: Priority) -> Bool {
+            lhs.rawValue < rhs.rawValue
+        }
+        
+        var description: String {
+            switch self {
+            case .housekeeping: return "housekeeping"
+            case .background: return "background"
+            case .interactive: return "interactive"
+            }
+        }
+    }
+    
+    struct Metrics: CustomStringConvertible {
+        /// Jobs waiting for the card, by priority.
+        fileprivate(set) var depths: [Priority: Int] = [:]
+        /// Producers waiting for room in the queue.
+        fileprivate(set) var blockedProducersCount = 0
+        /// Time from being submitted to starting, by priority.
+        fileprivate(set) var waits: [Priority: APDULatencyHistogram] = [:]
+        fileprivate(set) var completedCount = 0
+        /// Jobs cancelled before they started.
+        fileprivate(set) var cancelledCount = 0
+        
+        var depth: Int {
+            depths.values.reduce(0, +)
+        }
+        
+        var description: String {
+            let waits = Priority.allCases.reversed().compactMap { priority in
+                self.waits[priority].map { "\(priority) wait \($0)" }
+            }
+            
+            return (["depth \(depth)", "\(blockedProducersCount) blocked", "\(completedCount) completed", "\(cancelledCount) cancelled"] + waits).joined(separator: ", ")
+        }
+    }
+    
+    private struct Job: Waiting {
+        let id: UInt64
+        let priority: Priority
+        let submittedAt: UInt64
+        /// Set once the job's task waits for its turn.
+        var continuation: CheckedContinuation<Void, Error>?
+    }
+    
+    private struct Producer: Waiting {
+        let id: UInt64
+        let priority: Priority
+        let continuation: CheckedContinuation<Void, Error>
+    }
+    
+    /// Jobs waiting before producers are held back.
+    let capacity: Int
+    
+    private var queued: [Job] = []
+    private var producers: [Producer] = []
+    /// Jobs given the card before their task started waiting for it.
+    private var granted: Set<UInt64> = []
+    private var isBusy = false
+    private var nextID: UInt64 = 0
+    private(set) var metrics = Metrics()
+    
+    init(capacity: Int = 16) {
+        self.capacity = capacity
+    }
+    
+    // MARK: - Shared
+    
+    private static let lock = NSLock()
+    private static var schedulers: [UUID: APDUDeviceScheduler] = [:]
+    
+    /// The scheduler of `device`, every runner of the same device goes through the same one.
+    static func shared(for device: DeviceProtocol) -> APDUDeviceScheduler {
+        lock.lock()
+        defer { lock.unlock() }
+        
+        if let scheduler = schedulers[device.id] {
+            return scheduler
+        }
+        
+        let scheduler = APDUDeviceScheduler()
+        schedulers[device.id] = scheduler
+        return scheduler
+    }
+    
+    // MARK: - Submitting
+    
+    /// Queues `work`, suspends while the queue is full. The returned task runs `work` once it's the job's turn, cancel it to drop the job.
+    func submit<T>(_ priority: Priority, _ work: @escaping () async throws -> T) async throws -> Task<T, Error> {
+        while priority != .interactive, queued.count >= capacity {
+            try await waitForRoom(priority)
+        }
+        
+        let id = makeID()
+        queued.append(Job(id: id, priority: priority, submittedAt: DispatchTime.now().uptimeNanoseconds))
+        metrics.depths[priority, default: 0] += 1
+        
+        let task = Task<T, Error> {
+            try await self.waitForTurn(id)
+            
+            do {
+                let value = try await work()
+                self.finish()
+                return value
+            } catch {
+                self.finish()
+                throw error
+            }
+        }
+        
+        startNextIfIdle()
+        return task
+    }
+    
+    /// Submits `work` and waits for its result, cancelling the calling task cancels the job.
+    func perform<T>(_ priority: Priority, _ work: @escaping () async throws -> T) async throws -> T {
+        let task = try await submit(priority, work)
+        
+        return try await withTaskCancellationHandler {
+            try await task.value
+        } onCancel: {
+            task.cancel()
+        }
+    }
+    
+    // MARK: - Turns
+    
+    private func makeID() -> UInt64 {
+        defer { nextID += 1 }
+        return nextID
+    }
+    
+    private func waitForTurn(_ id: UInt64) async throws {
+        guard granted.remove(id) == nil else { return }
+        
+        try await withTaskCancellationHandler {
+            try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Void, Error>) in
+                guard let index = queued.firstIndex(where: { $0.id == id }) else {
+                    continuation.resume(throwing: CancellationError())
+                    return
+                }
+                
+                queued[index].continuation = continuation
+            }
+        } onCancel: {
+            Task { await self.cancel(id) }
+        }
+    }
+    
+    /// Gives the card to the first waiting job of the highest priority.
+    private func startNextIfIdle() {
+        guard !isBusy, let next = queued.nextIndex else { return }
+        
+        let job = queued.remove(at: next)
+        isBusy = true
+        metrics.depths[job.priority, default: 0] -= 1
+        metrics.waits[job.priority, default: APDULatencyHistogram()].record(DispatchTime.now().uptimeNanoseconds - job.submittedAt)
+        
+        if let continuation = job.continuation {
+            continuation.resume()
+        } else {
+            granted.insert(job.id)
+        }
+        
+        makeRoom()
+    }
+    
+    private func finish() {
+        isBusy = false
+        metrics.completedCount += 1
+        startNextIfIdle()
+    }
+    
+    private func cancel(_ id: UInt64) {
+        guard let index = queued.firstIndex(where: { $0.id == id }) else { return }
+        
+        let job = queued.remove(at: index)
+        metrics.depths[job.priority, default: 0] -= 1
+        metrics.cancelledCount += 1
+        job.continuation?.resume(throwing: CancellationError())
+        makeRoom()
+    }
+    
+    // MARK: - Backpressure
+    
+    private func waitForRoom(_ priority: Priority) async throws {
+        let id = makeID()
+        
+        try await withTaskCancellationHandler {
+            try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Void, Error>) in
+                producers.append(Producer(id: id, priority: priority, continuation: continuation))
+                metrics.blockedProducersCount += 1
+            }
+        } onCancel: {
+            Task { await self.cancelProducer(id) }
+        }
+    }
+    
+    /// Wakes the producers of the highest priority up while there's room, they check for it again.
+    private func makeRoom() {
+        var room = capacity - queued.count
+        while room > 0, let next = producers.nextIndex {
+            let producer = producers.remove(at: next)
+            metrics.blockedProducersCount -= 1
+            producer.continuation.resume()
+            room -= 1
+        }
+    }
+    
+    private func cancelProducer(_ id: UInt64) {
+        guard let index = producers.firstIndex(where: { $0.id == id }) else { return }
+        
+        let producer = producers.remove(at: index)
+        metrics.blockedProducersCount -= 1
+        producer.continuation.resume(throwing: CancellationError())
+    }
+}
+
+private protocol Waiting {
+    var id: UInt64 { get }
+    var priority: APDUDeviceScheduler.Priority { get }
+}
+
+private extension Array where Element: Waiting {
+    /// The first entry of the highest priority, ids grow in submission order.
+    var nextIndex: Int? {
+        indices.max { self[$0].priority < self[$1].priority || (self[$0].priority == self[$1].priority && self[$0].id > self[$1].id) }
+    }
+}
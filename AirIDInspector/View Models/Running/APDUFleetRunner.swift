@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUFleetRunner.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Runs the same test on many devices at once, one child task per device.
+ 
+ Every device runs its own replica of the table and fills its own report, so a device failing, stopping early or being slower doesn't touch the states or measurements of the others. The reports are merged into an `APDUFleetReport` once every device is done.
+ */
+struct APDUFleetRunner {
+    let executionMode: APDUTestsViewModel.ExecutionMode
+    
+    init(executionMode: APDUTestsViewModel.ExecutionMode = .serial) {
+        self.executionMode = executionMode
+    }
+    
+    /// Runs every row of `table` on each of `devices`, `table` itself is left untouched.
+    @MainActor
+    func run(_ table: APDUOperationTable, on devices: [DeviceProtocol]) async -> APDUFleetReport {
+        var fleetReport = APDUFleetReport()
+        
+        return await withTaskGroup(of: APDUFleetReport.DeviceRun.self) { group in
+            for device in devices {
+                let replica = table.replica()
+                group.addTask {
+                    await runReplica(replica, on: device)
+                }
+            }
+            
+            for await deviceRun in group {
+                fleetReport.add(deviceRun)
+            }
+            
+            return fleetReport
+        }
+    }
+    
+    /// Waits for the card behind the other runs of the device.
+    private func runReplica(_ table: APDUOperationTable, on device: DeviceProtocol) async -> APDUFleetReport.DeviceRun {
+        var report = APDURunReport()
+        var runError: Error?
+        
+        do {
+            try await APDUDeviceScheduler.shared(for: device).perform(.background) {
+                _ = await executionMode.run(table, rows: table.indices, on: device, report: &report)
+                try await device.shutDown()
+            }
+        } catch {
+            runError = error
+        }
+        
+        return .init(deviceID: device.id,
+                     table: table,
+                     report: report,
+                     failedRow: table.indices.first { table.stateCode(at: $0) == .failed },
+                     error: runError)
+    }
+}
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUJobQueue.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Independent units of work shared by the devices of a sharded run, units are identified by their index.
+ 
+ Devices pull a unit whenever they're done with the previous one, so a faster device ends up running more units. A unit given back by a device which dropped goes to a device waiting for work, or to the front of the queue.
+ */
+actor APDUJobQueue {
+    /// Units not handed out yet, the next one last.
+    private var pending: [Int]
+    private var inFlightCount = 0
+    /// Devices waiting for a unit which may still be given back.
+    private var waiters: [CheckedContinuation<Int?, Never>] = []
+    
+    init(unitsCount: Int) {
+        self.pending = Array((0..<unitsCount).reversed())
+    }
+    
+    /// Units which were never handed out or were given back, in order.
+    var remaining: [Int] {
+        pending.sorted()
+    }
+    
+    /// The next unit to run, nil once every unit has been completed. Waits while the queue is empty but units are still running elsewhere.
+    func next() async -> Int? {
+        if let unit = pending.popLast() {
+            inFlightCount += 1
+            return unit
+        }
+        
+        guard inFlightCount > 0 else { return nil }
+        return await withCheckedContinuation { waiters.append($0) }
+    }
+    
+    /// Marks a unit handed out by `next()` as done, whether it passed or failed.
+    func complete(_ unit: Int) {
+        inFlightCount -= 1
+        guard inFlightCount == 0, pending.isEmpty else { return }
+        
+        waiters.forEach { $0.resume(returning: nil) }
+        waiters.removeAll()
+    }
+    
+    /// Gives back a unit handed out by `next()` which couldn't be run.
+    func requeue(_ unit: Int) {
+        guard waiters.isEmpty else {
+            // stays in flight, on another device
+            waiters.removeFirst().resume(returning: unit)
+            return
+        }
+        
+        inFlightCount -= 1
+        pending.append(unit)
+    }
+}
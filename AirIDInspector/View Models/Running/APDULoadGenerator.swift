@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDULoadGenerator.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Sends the APDUs of a table on a schedule instead of one after the other's response, an open loop like a client which doesn't wait on the card to decide when to transact.
+ 
+ Every APDU has an intended send time given by the schedule. The link carries one APDU at a time, so an APDU whose time came while the card was still busy is sent as soon as the card answers, and its latency is counted from the intended time: a stall shows up in every APDU queued behind it, as it would for real clients, rather than only in the one which stalled.
+ */
+struct APDULoadGenerator {
+    enum Schedule: Equatable {
+        /// evenly spaced APDUs
+        case fixedRate(perSecond: Double)
+        /// APDUs arriving independently of each other at an average rate
+        case poisson(perSecond: Double)
+        /// `size` APDUs due at once, `perSecond` times a second
+        case bursts(size: Int, perSecond: Double)
+        
+        /// The average APDUs per second.
+        var rate: Double {
+            switch self {
+            case .fixedRate(let perSecond), .poisson(let perSecond):
+                return perSecond
+            case .bursts(let size, let perSecond):
+                return Double(size) * perSecond
+            }
+        }
+        
+        /// A positive, finite rate, and bursts of at least one APDU, anything else never advances or never ends.
+        var isValid: Bool {
+            switch self {
+            case .fixedRate(let perSecond), .poisson(let perSecond):
+                return perSecond.isFinite && perSecond > 0
+            case .bursts(let size, let perSecond):
+                return size > 0 && perSecond.isFinite && perSecond > 0
+            }
+        }
+    }
+    
+    let schedule: Schedule
+    /// Nanoseconds over which APDUs are scheduled.
+    let duration: UInt64
+    /// Nanoseconds the client pauses after every pass through the script, before its next transaction.
+    let thinkTime: UInt64
+    let seed: UInt64
+    
+    init(schedule: Schedule, duration: UInt64, thinkTime: UInt64 = 0, seed: UInt64 = UInt64.random(in: .min ... .max)) {
+        precondition(schedule.isValid, "invalid schedule \(schedule)")
+        self.schedule = schedule
+        self.duration = duration
+        self.thinkTime = thinkTime
+        self.seed = seed
+    }
+    
+    /// Intended send times of the APDUs, in nanoseconds from the start of the run.
+    struct Arrivals: Sequence, IteratorProtocol {
+        let generator: APDULoadGenerator
+        /// APDUs per pass through the script, think time follows every pass.
+        let transactionSize: Int
+        
+        private var random: SplitMix64
+        private var offset: Double = 0
+        private var index = 0
+        
+        init(generator: APDULoadGenerator, transactionSize: Int) {
+            self.generator = generator
+            self.transactionSize = transactionSize
+            self.random = SplitMix64(seed: generator.seed)
+        }
+        
+        mutating func next() -> UInt64? {
+            guard offset < Double(generator.duration) else { return nil }
+            
+            let current = UInt64(offset)
+            index += 1
+            
+            switch generator.schedule {
+            case .fixedRate(let perSecond):
+                offset += 1_000_000_000 / perSecond
+            case .poisson(let perSecond):
+                // exponentially distributed gaps, 1 - U keeps the logarithm finite
+                let uniform = 1 - Double(random.next() >> 11) / Double(1 << 53)
+                offset += -log(uniform) / perSecond * 1_000_000_000
+            case .bursts(let size, let perSecond):
+                if index % size == 0 {
+                    offset += 1_000_000_000 / perSecond
+                }
+            }
+            
+            if transactionSize > 0, index % transactionSize == 0 {
+                offset += Double(generator.thinkTime)
+            }
+            
+            return current
+        }
+    }
+    
+    func arrivals(transactionSize: Int) -> Arrivals {
+        Arrivals(generator: self, transactionSize: transactionSize)
+    }
+    
+    /**
+     Runs the header rows of `table` once to set the card up, then sends its APDU rows in turn, over and over, on the schedule.
+     
+     Rows aren't updated, the report holds the measurements.
+     */
+    @MainActor
+    func run(_ table: APDUOperationTable, on device: DeviceProtocol) async throws -> APDULoadReport {
+        var setupReport = APDURunReport()
+        for row in table.leadingHeaderRows {
+            guard await table.run(row, on: device, report: &setupReport) else {
+                throw OperationError.explicit("Setting the card up failed at row \(row)")
+            }
+        }
+        
+        let rows = table.indices.filter { table.type(at: $0) == .apduTest }
+        guard !rows.isEmpty else { throw OperationError.explicit("No APDUs to send") }
+        
+        let commands = rows.map { table.command(at: $0)! }
+        let matchers = rows.map { table.matcher(at: $0)! }
+        
+        var report = APDULoadReport(schedule: schedule)
+        let startedAt = DispatchTime.now().uptimeNanoseconds
+        
+        for (index, offset) in arrivals(transactionSize: rows.count).enumerated() {
+            try Task.checkCancellation()
+            
+            let intendedAt = startedAt + offset
+            let now = DispatchTime.now().uptimeNanoseconds
+            if intendedAt > now {
+                try await Task.sleep(nanoseconds: intendedAt - now)
+            }
+            
+            let sentAt = DispatchTime.now().uptimeNanoseconds
+            let response = try await device.sendAPDU(with: commands[index % rows.count])
+            let receivedAt = DispatchTime.now().uptimeNanoseconds
+            
+            report.record(intendedAt: intendedAt, sentAt: sentAt, receivedAt: receivedAt, matches: matchers[index % rows.count].matches(response))
+        }
+        
+        return report
+    }
+}
+
+/// Small seedable generator, so a Poisson schedule can be replayed.
+struct SplitMix64: RandomNumberGenerator {
+    private var state: UInt64
+    
+    init(seed: UInt64) {
+        self.state = seed
+    }
+    
+    mutating func next() -> UInt64 {
+        state &+= 0x9E3779B97F4A7C15
+        var z = state
+        z = (z ^ (z >> 30)) &* 0xBF58476D1CE4E5B9
+        z = (z ^ (z >> 27)) &* 0x94D049BB133111EB
+        return z ^ (z >> 31)
+    }
+}
@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUPipelinedRunner.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Runs the APDU rows of a table in three stages, so the link doesn't wait on the runner between commands.
+ 
+ - Submitting: commands are sent in batches through `DeviceProtocol.sendAPDUs(with:)`, the next batch is prepared while the current one is on the link. Responses are matched as soon as a batch is back, before the next one is sent.
+ - Recording: latencies and outcomes are collected on a separate task.
+ - Publishing: outcomes reach the table in one main actor hop per `publishInterval`, one display refresh by default.
+ 
+ A batch goes out as a whole, so at most the `batchSize - 1` commands following a mismatch in its batch are sent, never a batch after it. A batch size of 1 keeps the stop semantics of a serial run while still keeping the main actor off the link.
+ */
+struct APDUPipelinedRunner {
+    static let defaultBatchSize = 8
+    static let defaultPublishInterval = APDUChangeCoalescer.defaultInterval
+    
+    let batchSize: Int
+    /// Nanoseconds between two publications of outcomes.
+    let publishInterval: UInt64
+    
+    init(batchSize: Int = APDUPipelinedRunner.defaultBatchSize, publishInterval: UInt64 = APDUPipelinedRunner.defaultPublishInterval) {
+        precondition(batchSize > 0)
+        self.batchSize = batchSize
+        self.publishInterval = publishInterval
+    }
+    
+    private struct SubmittedBatch {
+        let rows: [APDUOperationTable.PreparedRow]
+        let exchanges: [APDUExchange]
+        /// The failure of every exchange, nil when its response matched, checked by the submitter.
+        let failures: [OperationError?]
+        /// Error of the command right after the exchanges.
+        let error: Error?
+    }
+    
+    /// Runs `rows` of `table` on `device`, returns false if the run should stop. Header rows are run one by one through the table.
+    func run(_ table: APDUOperationTable, rows: Range<Int>, on device: DeviceProtocol, report: inout APDURunReport) async -> Bool {
+        var row = rows.lowerBound
+        
+        while row < rows.upperBound {
+            guard table.type(at: row) == .apduTest else {
+                guard await table.run(row, on: device, report: &report) else { return false }
+                row += 1
+                continue
+            }
+            
+            let segment = await runSegment(of: table, from: row, upTo: rows.upperBound, on: device, report: report)
+            report = segment.report
+            guard segment.isRunning else { return false }
+            row = segment.end
+        }
+        
+        return true
+    }
+    
+    /// Runs the APDU rows from `start` until the next header row.
+    private func runSegment(of table: APDUOperationTable,
+                            from start: Int,
+                            upTo upperBound: Int,
+                            on device: DeviceProtocol,
+                            report initialReport: APDURunReport) async -> (end: Int, report: APDURunReport, isRunning: Bool) {
+        var isStopped = false
+        var continuation: AsyncStream<SubmittedBatch>.Continuation!
+        let batches = AsyncStream<SubmittedBatch> { continuation = $0 }
+        
+        let validator = Task { [publishInterval] () -> APDURunReport in
+            var report = initialReport
+            var outcomes: [APDUOperationTable.RowOutcome] = []
+            var publishedAt = DispatchTime.now().uptimeNanoseconds
+            
+            for await batch in batches {
+                for ((prepared, exchange), failure) in zip(zip(batch.rows, batch.exchanges), batch.failures) {
+                    report.record(exchange)
+                    outcomes.append(.init(row: prepared.row, duration: exchange.duration, error: failure))
+                }
+                
+                if let error = batch.error, batch.exchanges.count < batch.rows.count {
+                    let failure: OperationError = error is CancellationError ? .cancelled : .explicit(error.localizedDescription)
+                    outcomes.append(.init(row: batch.rows[batch.exchanges.count].row, duration: nil, error: failure))
+                }
+                
+                let now = DispatchTime.now().uptimeNanoseconds
+                if now - publishedAt >= publishInterval {
+                    await table.apply(outcomes)
+                    outcomes.removeAll(keepingCapacity: true)
+                    publishedAt = now
+                }
+            }
+            
+            await table.apply(outcomes)
+            return report
+        }
+        
+        var batch = await table.prepare(start..<min(start + batchSize, upperBound))
+        var end = start
+        
+        while let last = batch.last {
+            end = last.row + 1
+            // a short batch stopped on a header row
+            let isSegmentOver = batch.count < batchSize || end >= upperBound
+            
+            // the next batch is prepared while this one is on the link
+            async let following = nextBatch(of: table, from: end, upTo: upperBound, skip: isSegmentOver)
+            
+            var exchanges: [APDUExchange] = []
+            var error: Error?
+            do {
+                try Task.checkCancellation()
+                exchanges = try await device.sendAPDUs(with: batch.map(\.command))
+            } catch let batchError as APDUBatchError {
+                exchanges = batchError.exchanges
+                error = batchError.underlyingError
+            } catch let failure {
+                error = failure
+            }
+            
+            // matching is cheap next to a round trip, doing it here keeps the next batch from going out after a mismatch
+            let failures = zip(batch, exchanges).map { $0.matcher.failure(for: $1.response) }
+            isStopped = error != nil || failures.contains { $0 != nil }
+            continuation.yield(SubmittedBatch(rows: batch, exchanges: exchanges, failures: failures, error: error))
+            
+            batch = await following
+            if isSegmentOver || isStopped {
+                break
+            }
+        }
+        
+        continuation.finish()
+        let report = await validator.value
+        
+        if isStopped {
+            // rows prepared ahead of the failure never ran
+            await table.resetRunningRows(in: start..<min(end + batchSize, upperBound))
+        }
+        
+        return (end, report, !isStopped)
+    }
+    
+    private func nextBatch(of table: APDUOperationTable, from start: Int, upTo upperBound: Int, skip: Bool) async -> [APDUOperationTable.PreparedRow] {
+        guard !skip, start < upperBound else { return [] }
+        return await table.prepare(start..<min(start + batchSize, upperBound))
+    }
+}
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUProtocolComparison.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Sends the APDU rows of a table under T=0 and under T=1 on the same card, to tell which protocol the card answers faster and whether it answers the same.
+ 
+ Every pass resets the card and selects its protocol before the APDUs, header rows of the table are ignored. The protocols alternate A B B A over the rounds so the one which goes second isn't favoured by a warmed up card or link.
+ */
+struct APDUProtocolComparison {
+    static let protocols: [AIPCardProtocol] = [.T0, .T1]
+    
+    let rounds: Int
+    
+    init(rounds: Int = 10) {
+        self.rounds = rounds
+    }
+    
+    /// The card is shut down at the end.
+    @MainActor
+    func run(_ table: APDUOperationTable, on device: DeviceProtocol) async throws -> APDUProtocolComparisonReport {
+        let rows = table.indices.filter { table.type(at: $0) == .apduTest }
+        guard !rows.isEmpty else { throw OperationError.explicit("No APDUs to send") }
+        
+        let commands = rows.map { table.command(at: $0)! }
+        var report = APDUProtocolComparisonReport(rows: rows)
+        
+        for round in 0..<rounds {
+            let protocols = round % 4 == 1 || round % 4 == 2 ? Array(Self.protocols.reversed()) : Self.protocols
+            for cardProtocol in protocols {
+                try Task.checkCancellation()
+                try await send(commands, under: cardProtocol, on: device, report: &report)
+            }
+            
+            report.completeRound()
+        }
+        
+        try await device.shutDown()
+        return report
+    }
+    
+    @MainActor
+    private func send(_ commands: [Data], under cardProtocol: AIPCardProtocol, on device: DeviceProtocol, report: inout APDUProtocolComparisonReport) async throws {
+        _ = try await device.wakeUp()
+        
+        do {
+            try await device.selectProtocol(cardProtocol: cardProtocol)
+        } catch {
+            throw OperationError.explicit("The card refused \(cardProtocol): \(error.localizedDescription)")
+        }
+        
+        var exchanges: [APDUExchange] = []
+        for command in commands {
+            exchanges.append(try await device.exchangeAPDU(with: command))
+        }
+        
+        report.record(exchanges, under: cardProtocol)
+    }
+}
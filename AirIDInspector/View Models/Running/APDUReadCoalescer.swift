@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUReadCoalescer.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Runs consecutive READ BINARY rows reading contiguous offsets as a single extended length read, so a file read out in short chunks costs one round trip per `responseSize` instead of one per chunk.
+ 
+ Reads are only merged when the ATR of the card declares extended lengths, up to what the device carries in a response. The merged response is split back into the chunks the rows asked for and every row is checked against its own expected response, a row gets its share of the latency by the bytes it read. A merged read which doesn't come back whole with 9000, e.g. at the end of the file, is sent again row by row.
+ */
+struct APDUReadCoalescer {
+    /// A READ BINARY row with an offset in P1 P2.
+    struct Read: Equatable {
+        let row: Int
+        let cla: UInt8
+        let offset: Int
+        let length: Int
+    }
+    
+    enum Step: Equatable {
+        case row(Int)
+        case merged([Read])
+    }
+    
+    /// The read of `row`, nil if it isn't a short READ BINARY of the current file.
+    static func read(at row: Int, of table: APDUOperationTable) -> Read? {
+        guard let data = table.command(at: row), data.count == 5,
+              let command = APDUCommand(data), command.header[1] == 0xB0, command.header[2] & 0x80 == 0,
+              let length = command.expectedLength else { return nil }
+        
+        return Read(row: row, cla: command.header[0], offset: Int(command.header[2]) << 8 | Int(command.header[3]), length: length)
+    }
+    
+    /// Groups the reads of `rows` which follow each other into merged steps of at most `maximumLength` bytes, every other row is a step of its own.
+    static func plan(_ table: APDUOperationTable, rows: Range<Int>, maximumLength: Int) -> [Step] {
+        var steps: [Step] = []
+        var pending: [Read] = []
+        
+        func flush() {
+            if pending.count > 1 {
+                steps.append(.merged(pending))
+            } else {
+                steps.append(contentsOf: pending.map { .row($0.row) })
+            }
+            
+            pending.removeAll()
+        }
+        
+        for row in rows {
+            guard let read = read(at: row, of: table) else {
+                flush()
+                steps.append(.row(row))
+                continue
+            }
+            
+            if let last = pending.last {
+                let isContiguous = read.cla == last.cla && read.offset == last.offset + last.length
+                let length = pending.reduce(0) { $0 + $1.length } + read.length
+                if !isContiguous || length > maximumLength || read.offset + read.length > 0x8000 {
+                    flush()
+                }
+            }
+            
+            pending.append(read)
+        }
+        
+        flush()
+        return steps
+    }
+    
+    /// Runs `rows` of `table` on `device`, returns false if the run should stop. Header rows run first, the ATR they read tells whether reads can be merged.
+    @MainActor
+    func run(_ table: APDUOperationTable, rows: Range<Int>, on device: DeviceProtocol, report: inout APDURunReport) async -> Bool {
+        let headerRows = table.leadingHeaderRows.clamped(to: rows)
+        for row in headerRows {
+            guard await table.run(row, on: device, report: &report) else { return false }
+        }
+        
+        // a warm run which skipped the header still has the ATR of the last one
+        let atr = table.leadingHeaderRows.compactMap { table.responseATR(at: $0) }.last ?? Data()
+        let maximumLength = APDUCardCapabilities(atr: atr).supportsExtendedLength ? min(device.linkLimits.responseSize - 2, 0xFFFF) : 0
+        
+        for step in Self.plan(table, rows: headerRows.upperBound..<rows.upperBound, maximumLength: maximumLength) {
+            switch step {
+            case .row(let row):
+                guard await table.run(row, on: device, report: &report) else { return false }
+            case .merged(let reads):
+                guard await run(reads, of: table, on: device, report: &report) else { return false }
+            }
+        }
+        
+        return true
+    }
+    
+    @MainActor
+    private func run(_ reads: [Read], of table: APDUOperationTable, on device: DeviceProtocol, report: inout APDURunReport) async -> Bool {
+        let first = reads[0]
+        let total = reads.reduce(0) { $0 + $1.length }
+        let command = Data([first.cla, 0xB0, UInt8(first.offset >> 8), UInt8(first.offset & 0xFF), 0x00, UInt8(total >> 8), UInt8(total & 0xFF)])
+        reads.forEach { table.setState(.running, at: $0.row) }
+        
+        let exchange: APDUExchange
+        do {
+            try Task.checkCancellation()
+            exchange = try await device.exchangeAPDU(with: command)
+        } catch {
+            let failure = error is CancellationError ? OperationError.cancelled : OperationError.explicit(error.localizedDescription)
+            reads.forEach { table.setState(.failed(failure), at: $0.row) }
+            return false
+        }
+        
+        let response = exchange.response
+        guard response.count == total + 2, response.suffix(2) == Data([0x90, 0x00]) else {
+            // the card read less than asked, the rows find out what on their own
+            for read in reads {
+                guard await table.run(read.row, on: device, report: &report) else { return false }
+            }
+            
+            return true
+        }
+        
+        report.record(exchange)
+        
+        var start = response.startIndex
+        for (index, read) in reads.enumerated() {
+            let chunk = response[start..<start + read.length] + response.suffix(2)
+            start += read.length
+            table.record(duration: exchange.duration * MeasurementNanoseconds(read.length) / MeasurementNanoseconds(total), at: read.row)
+            
+            let matcher = table.matcher(at: read.row)!
+            guard matcher.matches(chunk) else {
+                table.setState(.failed(.invalidResponse(chunk.suffix(2), matcher.expectedData)), at: read.row)
+                reads[(index + 1)...].forEach { table.setState(.pending, at: $0.row) }
+                return false
+            }
+            
+            table.setState(.success, at: read.row)
+        }
+        
+        return true
+    }
+}
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUShardedRunner.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Spreads independent units, e.g. one card to personalize or read out per unit, over many devices.
+ 
+ Every device pulls its next unit from a shared `APDUJobQueue` as soon as it's done with the previous one, so the run scales with the number of devices instead of waiting on the slowest. A unit whose response doesn't match fails on its own, a unit interrupted by the device itself is reset and given back to the queue while that device leaves the run.
+ */
+struct APDUShardedRunner {
+    let executionMode: APDUTestsViewModel.ExecutionMode
+    
+    init(executionMode: APDUTestsViewModel.ExecutionMode = .serial) {
+        self.executionMode = executionMode
+    }
+    
+    /// Runs each of `units` once on whichever of `devices` is free, every unit is its own table.
+    @MainActor
+    func run(_ units: [APDUOperationTable], on devices: [DeviceProtocol]) async -> APDUShardReport {
+        let queue = APDUJobQueue(unitsCount: units.count)
+        var shardReport = APDUShardReport(unitsCount: units.count)
+        
+        await withTaskGroup(of: APDUShardReport.Worker.self) { group in
+            for device in devices {
+                group.addTask {
+                    await work(on: device, units: units, queue: queue)
+                }
+            }
+            
+            for await worker in group {
+                shardReport.add(worker)
+            }
+        }
+        
+        shardReport.pendingUnits = await queue.remaining
+        return shardReport
+    }
+    
+    private enum Outcome {
+        case completed
+        /// a response didn't match, the unit isn't run again
+        case failed
+        /// the device dropped or the run was cancelled, the unit didn't fail
+        case interrupted
+    }
+    
+    private func work(on device: DeviceProtocol, units: [APDUOperationTable], queue: APDUJobQueue) async -> APDUShardReport.Worker {
+        var worker = APDUShardReport.Worker(deviceID: device.id)
+        let scheduler = APDUDeviceScheduler.shared(for: device)
+        
+        while let unit = await queue.next() {
+            let table = units[unit]
+            var report = worker.report
+            var outcome = Outcome.interrupted
+            var jobError: Error?
+            
+            do {
+                // waits for the card behind the other runs of the device, and keeps it until the card is shut down
+                try await scheduler.perform(.background) {
+                    guard !Task.isCancelled else { return }
+                    
+                    if await executionMode.run(table, rows: table.indices, on: device, report: &report) {
+                        outcome = .completed
+                    } else if table.indices.contains(where: { table.isResponseMismatch(at: $0) }) {
+                        outcome = .failed
+                    } else {
+                        return
+                    }
+                    
+                    // the card of the unit is done with, ready for the next one
+                    try await device.shutDown()
+                }
+            } catch {
+                jobError = error
+            }
+            
+            worker.report = report
+            
+            switch outcome {
+            case .completed:
+                worker.completedUnits.append(unit)
+            case .failed:
+                worker.failedUnits.append(unit)
+            case .interrupted:
+                worker.error = jobError ?? (Task.isCancelled ? CancellationError() : table.indices.lazy.compactMap { table.failure(at: $0) }.first)
+                await table.resetRows(in: table.indices)
+                await queue.requeue(unit)
+                return worker
+            }
+            
+            await queue.complete(unit)
+            
+            if let error = jobError {
+                worker.error = error
+                return worker
+            }
+        }
+        
+        return worker
+    }
+}
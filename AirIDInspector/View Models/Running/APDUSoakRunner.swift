@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUSoakRunner.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+import Combine
+import AirIDDriver
+
+/**
+ Runs a table over and over for hours, until a time or iteration budget is spent, riding out what a long run runs into.
+ 
+ - A device which dropped is connected again, through `DeviceProtocol.connect()`, waiting longer after every failed attempt. The card is set up again before the next iteration.
+ - An APDU failing without an answer from the card is sent again after a short backoff, a few times before its iteration is given up.
+ - A response which doesn't match is counted and the run goes on.
+ 
+ Measurements go into the rolling windows of `APDUSoakReport` rather than the rows, which keep the states of the header rows only.
+ */
+struct APDUSoakRunner {
+    enum Budget: Equatable {
+        /// nanoseconds, no iteration starts after they passed
+        case duration(UInt64)
+        case iterations(Int)
+    }
+    
+    let budget: Budget
+    /// Times an APDU is sent again before its iteration is given up.
+    var maximumRetries = 3
+    /// Nanoseconds before the first retry or reconnect, doubled after every failed attempt.
+    var initialBackoff: UInt64 = 100_000_000
+    var maximumBackoff: UInt64 = 30_000_000_000
+    /// Consecutive failed reconnects, or failed iterations, before the run is given up.
+    var maximumAttempts = 10
+    var windowDuration: UInt64 = 60_000_000_000
+    /// Windows kept by the report, an hour of one minute windows by default.
+    var windowsCount = 60
+    
+    init(budget: Budget) {
+        self.budget = budget
+    }
+    
+    /// The last status of the device, written on the driver's thread and read by the run.
+    private final class StatusBox {
+        private let lock = NSLock()
+        private var _status: DeviceStatus
+        
+        init(_ status: DeviceStatus) {
+            self._status = status
+        }
+        
+        var value: DeviceStatus {
+            get {
+                lock.lock()
+                defer { lock.unlock() }
+                return _status
+            }
+            set {
+                lock.lock()
+                _status = newValue
+                lock.unlock()
+            }
+        }
+    }
+    
+    /// Nanoseconds to wait before attempt `attempt`, counting from 1, with some jitter so devices dropped together don't retry in step.
+    func backoff(before attempt: Int) -> UInt64 {
+        let exponential = initialBackoff << UInt64(min(attempt - 1, 32))
+        let delay = min(exponential, maximumBackoff)
+        return delay / 2 + UInt64.random(in: 0...delay / 2)
+    }
+    
+    /// Whether `error` means the link to the device is gone, rather than a single exchange failing.
+    static func isDisconnection(_ error: Error, status: DeviceStatus) -> Bool {
+        if !status.isConnected {
+            return true
+        }
+        
+        let error = (error as? APDUBatchError)?.underlyingError ?? error
+        let nsError = error as NSError
+        guard nsError.domain == AIDDeviceErrorDomain else { return false }
+        
+        switch AIDDeviceError(rawValue: nsError.code) {
+        case .bluetooth, .bluetoothCommunication, .unexpectedConnectionAbort:
+            return true
+        default:
+            return false
+        }
+    }
+    
+    /**
+     Runs `table` until the budget is spent, the task is cancelled, or the device can't be reconnected, `progress` gets the report about once a second.
+     
+     The card is shut down at the end.
+     */
+    @MainActor
+    func run(_ table: APDUOperationTable, on device: DeviceProtocol, progress: ((APDUSoakReport) -> Void)? = nil) async throws -> APDUSoakReport {
+        let rows = table.indices.filter { table.type(at: $0) == .apduTest }
+        guard !rows.isEmpty else { throw OperationError.explicit("No APDUs to send") }
+        
+        let commands = rows.map { table.command(at: $0)! }
+        let matchers = rows.map { table.matcher(at: $0)! }
+        
+        let lastStatus = StatusBox(.connected)
+        let statusObservation = device.status.sink { lastStatus.value = $0 }
+        defer { statusObservation.cancel() }
+        
+        var report = APDUSoakReport(windowDuration: windowDuration, capacity: windowsCount)
+        var isSetUp = false
+        var failedAttempts = 0
+        var progressedAt = report.startedAt
+        
+        while !isSpent(report) {
+            try Task.checkCancellation()
+            
+            do {
+                if !isSetUp {
+                    try await setUp(table, on: device)
+                    isSetUp = true
+                }
+                
+                for (command, matcher) in zip(commands, matchers) {
+                    let (sentAt, response) = try await send(command, on: device, status: { lastStatus.value }, report: &report)
+                    report.record(sentAt: sentAt, receivedAt: DispatchTime.now().uptimeNanoseconds, matches: matcher.matches(response))
+                }
+                
+                report.completeIteration()
+                failedAttempts = 0
+            } catch is CancellationError {
+                throw CancellationError()
+            } catch {
+                // the card may be anywhere, the next iteration sets it up again
+                isSetUp = false
+                failedAttempts += 1
+                report.recordFailure(error, at: DispatchTime.now().uptimeNanoseconds)
+                
+                guard failedAttempts <= maximumAttempts else { throw error }
+                
+                if Self.isDisconnection(error, status: lastStatus.value) {
+                    try await reconnect(device, report: &report)
+                }
+            }
+            
+            // a fast card would refresh the views for every iteration
+            let now = DispatchTime.now().uptimeNanoseconds
+            if now - progressedAt >= 1_000_000_000 {
+                progressedAt = now
+                progress?(report)
+            }
+        }
+        
+        progress?(report)
+        
+        try await device.shutDown()
+        return report
+    }
+    
+    private func isSpent(_ report: APDUSoakReport) -> Bool {
+        switch budget {
+        case .duration(let duration):
+            return DispatchTime.now().uptimeNanoseconds >= report.startedAt + duration
+        case .iterations(let count):
+            return report.iterationsCount >= count
+        }
+    }
+    
+    /// Runs the header rows, throws the failure of the first one which failed.
+    @MainActor
+    private func setUp(_ table: APDUOperationTable, on device: DeviceProtocol) async throws {
+        var setupReport = APDURunReport()
+        for row in table.leadingHeaderRows {
+            guard await table.run(row, on: device, report: &setupReport) else {
+                throw table.failure(at: row) ?? OperationError.explicit("Setting the card up failed at row \(row)")
+            }
+        }
+    }
+    
+    /// Sends `command`, again after a backoff while it fails without the link dropping, returns when it was last sent and the response.
+    @MainActor
+    private func send(_ command: Data, on device: DeviceProtocol, status: () -> DeviceStatus, report: inout APDUSoakReport) async throws -> (UInt64, Data) {
+        var attempt = 0
+        
+        while true {
+            let sentAt = DispatchTime.now().uptimeNanoseconds
+            
+            do {
+                return (sentAt, try await device.sendAPDU(with: command))
+            } catch is CancellationError {
+                throw CancellationError()
+            } catch {
+                attempt += 1
+                guard attempt <= maximumRetries, !Self.isDisconnection(error, status: status()) else { throw error }
+                
+                report.recordRetry(at: DispatchTime.now().uptimeNanoseconds)
+                try await Task.sleep(nanoseconds: backoff(before: attempt))
+            }
+        }
+    }
+    
+    /// Connects `device` again, waiting longer after every failed attempt.
+    @MainActor
+    private func reconnect(_ device: DeviceProtocol, report: inout APDUSoakReport) async throws {
+        for attempt in 1...maximumAttempts {
+            try await Task.sleep(nanoseconds: backoff(before: attempt))
+            
+            do {
+                try await device.connect()
+                report.recordReconnect(at: DispatchTime.now().uptimeNanoseconds)
+                return
+            } catch {
+                // a failed attempt only backs the next one off longer, running out of attempts is reported below
+            }
+        }
+        
+        throw OperationError.explicit("The device couldn't be reconnected after \(maximumAttempts) attempts")
+    }
+}
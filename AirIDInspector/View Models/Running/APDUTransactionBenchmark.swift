@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: MIT
+//
+//  APDUTransactionBenchmark.swift
+//  AirIDDemo
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import Foundation
+
+/**
+ Sends the APDU rows of a table the way a run does, one by one, and within a single transaction, to measure what holding the card saves per APDU.
+ 
+ Every round sends all the APDUs once per variant. The variants alternate A B B A so a card or link warming up over the run doesn't favour the one which always goes second. Transaction rows of the table are ignored, the benchmark decides where the card is held.
+ */
+struct APDUTransactionBenchmark {
+    let rounds: Int
+    
+    init(rounds: Int = 20) {
+        self.rounds = rounds
+    }
+    
+    /// Runs the header rows of `table` once to set the card up, then the rounds. The card is shut down at the end.
+    @MainActor
+    func run(_ table: APDUOperationTable, on device: DeviceProtocol) async throws -> APDUTransactionBenchmarkReport {
+        var setupReport = APDURunReport()
+        for row in table.leadingHeaderRows {
+            guard await table.run(row, on: device, report: &setupReport) else {
+                throw table.failure(at: row) ?? OperationError.explicit("Setting the card up failed at row \(row)")
+            }
+        }
+        
+        let commands = table.indices.filter { table.type(at: $0) == .apduTest }.map { table.command(at: $0)! }
+        guard !commands.isEmpty else { throw OperationError.explicit("No APDUs to send") }
+        
+        var report = APDUTransactionBenchmarkReport(apdusPerRound: commands.count)
+        
+        for round in 0..<rounds {
+            let isTransactionFirst = round % 4 == 1 || round % 4 == 2
+            for inTransaction in [isTransactionFirst, !isTransactionFirst] {
+                try Task.checkCancellation()
+                try await send(commands, inTransaction: inTransaction, on: device, report: &report)
+            }
+            
+            report.completeRound()
+        }
+        
+        try await device.shutDown()
+        return report
+    }
+    
+    @MainActor
+    private func send(_ commands: [Data], inTransaction: Bool, on device: DeviceProtocol, report: inout APDUTransactionBenchmarkReport) async throws {
+        var overhead: MeasurementNanoseconds = 0
+        
+        if inTransaction {
+            let beganAt = DispatchTime.now().uptimeNanoseconds
+            try await device.beginTransaction()
+            overhead += DispatchTime.now().uptimeNanoseconds - beganAt
+        }
+        
+        for command in commands {
+            let sentAt = DispatchTime.now().uptimeNanoseconds
+            _ = try await device.sendAPDU(with: command)
+            report.record(DispatchTime.now().uptimeNanoseconds - sentAt, inTransaction: inTransaction)
+        }
+        
+        if inTransaction {
+            let endedAt = DispatchTime.now().uptimeNanoseconds
+            try await device.endTransaction(disposition: .leave)
+            overhead += DispatchTime.now().uptimeNanoseconds - endedAt
+            report.recordOverhead(overhead)
+        }
+    }
+}
@@ -7,6 +7,7 @@
 //
 
 import SwiftUI
+import UniformTypeIdentifiers
 
 struct APDUSourcePicker: View {
     enum APDURunType: String, Identifiable, CaseIterable {
@@ -37,14 +38,35 @@ struct APDUSourcePicker: View {
         }
     }
     
+    static let sourceTypes: [UTType] = [.text] + [UTType(filenameExtension: APDUCompiledScriptFormat.fileExtension, conformingTo: .data)].compactMap { $0 }
+    
+    /// Open loop runs of 30 seconds, generators are made when picked so every run gets its own seed.
+    static let loadPresets: [(name: String, generator: () -> APDULoadGenerator)] = [
+        ("20/s Fixed", { APDULoadGenerator(schedule: .fixedRate(perSecond: 20), duration: 30_000_000_000) }),
+        ("20/s Poisson", { APDULoadGenerator(schedule: .poisson(perSecond: 20), duration: 30_000_000_000) }),
+        ("Bursts of 10, 2/s", { APDULoadGenerator(schedule: .bursts(size: 10, perSecond: 2), duration: 30_000_000_000) }),
+        ("10/s Poisson, 1s Think Time", { APDULoadGenerator(schedule: .poisson(perSecond: 10), duration: 30_000_000_000, thinkTime: 1_000_000_000) })
+    ]
+    
+    static let soakPresets: [(name: String, budget: APDUSoakRunner.Budget)] = [
+        ("1 Hour", .duration(3_600_000_000_000)),
+        ("8 Hours", .duration(28_800_000_000_000)),
+        ("24 Hours", .duration(86_400_000_000_000)),
+        ("10,000 Runs", .iterations(10_000))
+    ]
+    
     @ObservedObject var viewModel: APDUTestsViewModel
     
     var body: some View {
         if self.viewModel.source == nil {
             BackgroundView {
-                FilePicker(types: [.text]) { urls in
+                FilePicker(types: Self.sourceTypes) { urls in
                     guard let url = urls.first else { return }
-                    self.viewModel.source = APDUTestSourceFile(url: url)
+                    if url.pathExtension == APDUCompiledScriptFormat.fileExtension {
+                        self.viewModel.source = APDUTestSourceCompiled(url: url)
+                    } else {
+                        self.viewModel.source = APDUTestSourceFile(url: url)
+                    }
                 } label: {
                     Label("Pick APDU Tests File", systemImage: "tray.and.arrow.down")
                 }
@@ -52,12 +74,53 @@ struct APDUSourcePicker: View {
         } else {
             BackgroundView {
                 HStack {
-                    Label("\(viewModel.operations.count) APDUs", systemImage: "filemenu.and.selection")
-                        .font(.body.bold())
+                    VStack(alignment: .leading, spacing: 5) {
+                        Label("\(viewModel.table.count) APDUs", systemImage: "filemenu.and.selection")
+                            .font(.body.bold())
+                        if viewModel.isStreamingSource {
+                            Text("REPEAT scripts run one APDU at a time on a cold card, the setup block runs every time and rows show the outline only")
+                                .font(.footnote)
+                                .foregroundColor(.orange)
+                        }
+                        if let report = viewModel.interningReport {
+                            Text(report.description)
+                                .font(.footnote.monospaced())
+                                .foregroundColor(.gray)
+                        }
+                        if let report = viewModel.lastRunReport {
+                            Text(report.description)
+                                .font(.footnote.monospaced())
+                                .foregroundColor(.gray)
+                        }
+                        if let report = viewModel.lastLoadReport {
+                            Text(report.description)
+                                .font(.footnote.monospaced())
+                                .foregroundColor(.gray)
+                        }
+                        if let report = viewModel.lastSoakReport {
+                            Text(report.description)
+                                .font(.footnote.monospaced())
+                                .foregroundColor(.gray)
+                        }
+                        if let report = viewModel.lastTransactionBenchmark {
+                            Text(report.description)
+                                .font(.footnote.monospaced())
+                                .foregroundColor(.gray)
+                        }
+                        if let report = viewModel.lastProtocolComparison {
+                            Text(report.description)
+                                .font(.footnote.monospaced())
+                                .foregroundColor(.gray)
+                        }
+                    }
                     Spacer()
                     HStack {
                         optionsButtonView
-                        runButtonView
+                        if viewModel.isSoaking {
+                            stopSoakButtonView
+                        } else {
+                            runButtonView
+                        }
                     }
                     .fixedSize(horizontal: true, vertical: true)
                     .frame(maxHeight: 100)
@@ -75,6 +138,30 @@ struct APDUSourcePicker: View {
                     Text(option.name)
                 }
             }
+            
+            Menu("Run on Schedule") {
+                ForEach(Self.loadPresets, id: \.name) { preset in
+                    Button(preset.name) {
+                        self.viewModel.startLoad(preset.generator())
+                    }
+                }
+            }
+            
+            Menu("Soak") {
+                ForEach(Self.soakPresets, id: \.name) { preset in
+                    Button(preset.name) {
+                        self.viewModel.startSoak(APDUSoakRunner(budget: preset.budget))
+                    }
+                }
+            }
+            
+            Button("Compare Transactions") {
+                self.viewModel.startTransactionBenchmark(APDUTransactionBenchmark())
+            }
+            
+            Button("Compare T=0 and T=1") {
+                self.viewModel.startProtocolComparison(APDUProtocolComparison())
+            }
         } label: {
             Image(systemName: "play.fill")
         } primaryAction: {
@@ -85,12 +172,37 @@ struct APDUSourcePicker: View {
         .disabled(viewModel.isOperationsRunning)
     }
     
+    var stopSoakButtonView: some View {
+        Button {
+            self.viewModel.stopSoak()
+        } label: {
+            Image(systemName: "stop.fill")
+        }
+        .controlSize(.large)
+        .buttonStyle(.borderedProminent)
+        .tint(.red)
+    }
+    
     var optionsButtonView: some View {
         Menu {
             Button("Export Test") {
                 // export the test
             }
             
+            Picker("Execution", selection: $viewModel.executionMode) {
+                ForEach(APDUTestsViewModel.ExecutionMode.allCases) { mode in
+                    Text(mode.rawValue.capitalized).tag(mode)
+                }
+            }
+            .disabled(viewModel.isStreamingSource)
+            
+            Picker("Between Runs", selection: $viewModel.runPolicy) {
+                ForEach(APDUTestsViewModel.RunPolicy.allCases) { policy in
+                    Text(policy.name).tag(policy)
+                }
+            }
+            .disabled(viewModel.isStreamingSource)
+            
             Button("Delete Test", role: .destructive) {
                 self.viewModel.source = nil
             }
@@ -9,27 +9,34 @@
 import SwiftUI
 
 struct APDUTestItemView: View {
-    @ObservedObject var operation: APDUBaseOperation
+    let row: APDUOperationTable.Row
+    /// The row's latencies over all previous runs.
+    var history: APDULatencyHistogram?
     
     var body: some View {
         BackgroundView {
             HStack {
                 VStack(alignment: .leading, spacing: 5) {
-                    Text(operation.name)
+                    Text(row.name)
                         .foregroundColor(.primary)
                         .font(.body.monospaced())
                         .bold()
-                    Text(operation.description)
+                    Text(row.description)
                         .font(.footnote.monospaced())
                         .foregroundColor(.gray)
-                    Text(operation.state.name)
-                        .foregroundColor(operation.state.color)
+                    if let history = history {
+                        Text(history.description)
+                            .font(.footnote.monospaced())
+                            .foregroundColor(.gray)
+                    }
+                    Text(row.state.name)
+                        .foregroundColor(row.state.color)
                         .font(.footnote.monospaced())
                         .bold()
                 }
                 
                 Spacer()
-                if operation.state.isLoading {
+                if row.state.isLoading {
                     ProgressView()
                         .progressViewStyle(.circular)
                 }
@@ -39,7 +46,7 @@ struct APDUTestItemView: View {
 }
 struct APDUTestItemView_Previews: PreviewProvider {
     static var previews: some View {
-        APDUTestItemView(operation: APDUTestOperation(device: MockedDevice.mocked(), data: "A1000".hexadecimal!, expectedResponse: "9000"))
+        APDUTestItemView(row: APDUOperationTable(entries: [.test(command: "A1000".hexadecimal!, expectedResponse: "9000")]).row(at: 0))
     }
 }
 
@@ -18,8 +18,10 @@ struct APDUTestsView: View {
                 
                 if viewModel.source != nil  {
                     Spacer().frame(height: 20)
-                    ForEach(viewModel.operations) { operation in
-                        APDUTestItemView(operation: operation)
+                    // rows are only created for the items the lazy stack displays
+                    ForEach(viewModel.table.indices, id: \.self) { index in
+                        let row = viewModel.table.row(at: index)
+                        APDUTestItemView(row: row, history: viewModel.histories[row.identity])
                     }
                 }
             }
@@ -7,6 +7,7 @@
 //
 
 import SwiftUI
+import UniformTypeIdentifiers
 
 struct DevicesListView<Manager: DevicesManagerProtocol>: View {
     @ObservedObject var viewModel: DevicesListViewModel<Manager>
@@ -23,7 +24,34 @@ struct DevicesListView<Manager: DevicesManagerProtocol>: View {
                         }
                     }
                     
+                    if let report = viewModel.fleetReport {
+                        Section(header: SectionLabel(text: "Fleet Run")) {
+                            Text(report.description)
+                                .font(.footnote.monospaced())
+                                .foregroundColor(.gray)
+                                .frame(maxWidth: .infinity, alignment: .leading)
+                                .padding(.horizontal)
+                        }
+                    }
+                    
+                    if let report = viewModel.shardReport {
+                        Section(header: SectionLabel(text: "Sharded Run")) {
+                            Text(report.description)
+                                .font(.footnote.monospaced())
+                                .foregroundColor(.gray)
+                                .frame(maxWidth: .infinity, alignment: .leading)
+                                .padding(.horizontal)
+                        }
+                    }
+                    
                     if !viewModel.connectedDevices.isEmpty {
+                        FilePicker(types: [.text], allowMultiple: true) { urls in
+                            viewModel.runSharded(scriptsAt: urls)
+                        } label: {
+                            Label("Spread Scripts over Connected Devices", systemImage: "square.stack.3d.down.right")
+                        }
+                        .disabled(viewModel.isFleetRunning)
+                        
                         Section(header: SectionLabel(text: "Connected Devices")) {
                             ForEach(viewModel.connectedDevices) { device in
                                 NavigationLink(destination: DeviceDetailsView(viewModel: device, operationsViewModel: device.testsViewModel)) {
@@ -32,7 +60,7 @@ struct DevicesListView<Manager: DevicesManagerProtocol>: View {
                             }
                         }
                     }
-
+                    
                     
                     if !viewModel.devices.isEmpty {
                         Section(header: SectionLabel(text: "Devices")) {
@@ -44,7 +72,17 @@ struct DevicesListView<Manager: DevicesManagerProtocol>: View {
                         }
                     }
                 }
-            }.navigationTitle("Devices")
+            }
+            .navigationTitle("Devices")
+            .toolbar {
+                Button {
+                    guard let testsViewModel = viewModel.fleetTestsViewModel else { return }
+                    viewModel.runOnConnectedDevices(testsViewModel)
+                } label: {
+                    Label("Run on Connected Devices", systemImage: "play.square.stack")
+                }
+                .disabled(viewModel.isFleetRunning || viewModel.connectedDevices.count < 2 || viewModel.fleetTestsViewModel == nil)
+            }
         }
     }
 }
@@ -0,0 +1,124 @@
+//
+//  APDUDeviceSchedulerTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class APDUDeviceSchedulerTests: XCTestCase {
+    
+    private func sleep(milliseconds: UInt64) async throws {
+        try await Task.sleep(nanoseconds: milliseconds * 1_000_000)
+    }
+    
+    @MainActor
+    func testJobsStartByPriority() async throws {
+        let scheduler = APDUDeviceScheduler()
+        var order: [APDUDeviceScheduler.Priority] = []
+        
+        // holds the card while the others queue up
+        let first = try await scheduler.submit(.background) { try await self.sleep(milliseconds: 50) }
+        
+        var tasks: [Task<Void, Error>] = []
+        for priority in [APDUDeviceScheduler.Priority.housekeeping, .background, .interactive, .background] {
+            tasks.append(try await scheduler.submit(priority) { @MainActor in order.append(priority) })
+        }
+        
+        try await first.value
+        for task in tasks {
+            try await task.value
+        }
+        
+        XCTAssertEqual(order, [.interactive, .background, .background, .housekeeping])
+        
+        let metrics = await scheduler.metrics
+        XCTAssertEqual(metrics.completedCount, 5)
+        XCTAssertEqual(metrics.depth, 0)
+        XCTAssertEqual(metrics.waits[.background]?.count, 3)
+        XCTAssertGreaterThanOrEqual(metrics.waits[.housekeeping]?.minimum ?? 0, 40_000_000)
+    }
+    
+    @MainActor
+    func testFullQueueHoldsProducersBack() async throws {
+        let scheduler = APDUDeviceScheduler(capacity: 2)
+        let first = try await scheduler.submit(.background) { try await self.sleep(milliseconds: 10_000) }
+        _ = try await scheduler.submit(.background) { }
+        _ = try await scheduler.submit(.background) { }
+        
+        let producer = Task { try await scheduler.submit(.housekeeping) { } }
+        try await sleep(milliseconds: 20)
+        
+        var metrics = await scheduler.metrics
+        XCTAssertEqual(metrics.depth, 2)
+        XCTAssertEqual(metrics.blockedProducersCount, 1)
+        
+        // a tap isn't held back
+        let interactive = try await scheduler.submit(.interactive) { }
+        metrics = await scheduler.metrics
+        XCTAssertEqual(metrics.depths[.interactive], 1)
+        
+        first.cancel()
+        try await producer.value.value
+        try await interactive.value
+        
+        metrics = await scheduler.metrics
+        XCTAssertEqual(metrics.blockedProducersCount, 0)
+        XCTAssertEqual(metrics.completedCount, 5)
+    }
+    
+    /// A link which, like the driver, only gives the card back once the round trip on it is over.
+    private final class SlowLinkDevice: MockedDevice {
+        private(set) var completedAt: UInt64 = 0
+        
+        override func sendAPDU(with data: Data) async throws -> Data {
+            // not cancelled with the caller
+            await Task.detached { try? await Task.sleep(nanoseconds: 200_000_000) }.value
+            completedAt = DispatchTime.now().uptimeNanoseconds
+            try Task.checkCancellation()
+            return Data([0x90, 0x00])
+        }
+    }
+    
+    @MainActor
+    func testCancellation() async throws {
+        let scheduler = APDUDeviceScheduler()
+        let device = SlowLinkDevice(id: UUID(), signalStrength: .medium, status: .connected)
+        
+        let running = try await scheduler.submit(.background) { try await device.sendAPDU(with: Data([0x00, 0xB0, 0x00, 0x00, 0x00])) }
+        var hasRun = false
+        let queued = try await scheduler.submit(.background) { @MainActor in hasRun = true }
+        var nextStartedAt: UInt64 = 0
+        let next = try await scheduler.submit(.background) { @MainActor in nextStartedAt = DispatchTime.now().uptimeNanoseconds }
+        
+        queued.cancel()
+        try await sleep(milliseconds: 20)
+        
+        running.cancel()
+        do {
+            _ = try await running.value
+            XCTFail("the APDU wasn't cancelled")
+        } catch {
+            XCTAssertTrue(error is CancellationError)
+        }
+        
+        // the card is only handed over once the APDU on the link is back
+        try await next.value
+        XCTAssertGreaterThan(device.completedAt, 0)
+        XCTAssertGreaterThanOrEqual(nextStartedAt, device.completedAt)
+        
+        do {
+            try await queued.value
+            XCTFail("the queued job wasn't cancelled")
+        } catch {
+            XCTAssertTrue(error is CancellationError)
+        }
+        
+        XCTAssertFalse(hasRun)
+        let metrics = await scheduler.metrics
+        XCTAssertEqual(metrics.cancelledCount, 1)
+        XCTAssertEqual(metrics.depth, 0)
+    }
+}
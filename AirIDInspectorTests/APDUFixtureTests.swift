@@ -0,0 +1,68 @@
+//
+//  APDUFixtureTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class APDUFixtureTests: XCTestCase {
+    
+    var device: MockedDevice!
+    
+    let script = """
+    T=1
+    BEGIN SETUP
+    00A4040007A0000000031010
+    9000
+    002000010831323334FFFFFFFF
+    9000
+    END SETUP
+    00B0000000
+    9000
+    """
+    
+    override func setUpWithError() throws {
+        self.device = MockedDevice(id: UUID(), signalStrength: .medium, status: .connected)
+    }
+    
+    func testSetupBlockIsParsed() async throws {
+        let operations = try APDUTestSourceString(string: script).getAPDUTestOperations(for: device)
+        XCTAssertEqual(operations.map(\.type), [.selectATR, .setProtocol, .fixture, .apduTest, .apduTest, .fixture, .apduTest])
+        
+        // without REPEAT the table is what runs, so it can skip the setup
+        let source = APDUTestSourceString(string: script, parsingMode: .sequential)
+        let table = try await source.loadAPDUOperationTable(for: device)
+        XCTAssertFalse(source.containsDirectives)
+        XCTAssertEqual(table.fixtureRows, 2..<6)
+        XCTAssertEqual(table.name(at: 5), "End Setup..")
+    }
+    
+    func testMisplacedSetupIsRefused() {
+        XCTAssertThrowsError(try APDUTestSourceString(string: "00A4040000\n9000\nBEGIN SETUP\n00B0000000\n9000\nEND SETUP\n").getAPDUTestOperations(for: device))
+        XCTAssertThrowsError(try APDUTestSourceString(string: "BEGIN SETUP\n00B0000000\n9000\n").getAPDUTestOperations(for: device))
+        
+        // only a setup leading the script is run once
+        let table = APDUOperationTable(entries: [.selectATR(nil), .transaction(.begin), .fixture(.begin), .fixture(.end), .transaction(.end(.leave))])
+        XCTAssertNil(table.fixtureRows)
+    }
+    
+    func testSetupHoldsUntilTheCardIsReset() async throws {
+        let table = try await APDUTestSourceString(string: script, parsingMode: .sequential).loadAPDUOperationTable(for: device)
+        var session = APDUCardSession()
+        table.leadingHeaderRows.forEach { session.apply($0, of: table) }
+        XCTAssertFalse(session.isFixtureEstablished(in: table))
+        
+        session.apply(5, of: table)
+        XCTAssertTrue(session.isFixtureEstablished(in: table))
+        
+        // an edited setup runs again
+        let edited = try await APDUTestSourceString(string: script.replacingOccurrences(of: "31323334", with: "35363738"), parsingMode: .sequential).loadAPDUOperationTable(for: device)
+        XCTAssertFalse(session.isFixtureEstablished(in: edited))
+        
+        session.apply(0, of: table)
+        XCTAssertFalse(session.isFixtureEstablished(in: table))
+    }
+}
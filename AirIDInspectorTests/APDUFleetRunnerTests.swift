@@ -0,0 +1,67 @@
+//
+//  APDUFleetRunnerTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class APDUFleetRunnerTests: XCTestCase {
+    
+    var devices: [MockedDevice]!
+    
+    override func setUpWithError() throws {
+        self.devices = MockedDevicesManager().connectedDevicesSubject.value
+        
+        for device in devices {
+            device.responseDelay = 100_000...500_000
+            device.setNextExpectedResponse(Data([0x90, 0x00]))
+        }
+    }
+    
+    func makeTable(count: Int) -> APDUOperationTable {
+        APDUOperationTable(entries: [.selectATR(nil)] + (0..<count).map { index in
+            .test(command: "00B0\(String(format: "%04X", index))00".hexadecimal!, expectedResponse: "9000")
+        })
+    }
+    
+    @MainActor
+    func testEveryDeviceRunsItsOwnReplica() async throws {
+        let table = makeTable(count: 20)
+        
+        for mode in APDUTestsViewModel.ExecutionMode.allCases {
+            let report = await APDUFleetRunner(executionMode: mode).run(table, on: devices)
+            
+            XCTAssertEqual(report.runs.count, devices.count)
+            XCTAssertTrue(report.failedRuns.isEmpty)
+            XCTAssertEqual(report.aggregate.latencies.count, UInt64(20 * devices.count))
+            
+            for device in devices {
+                let run = try XCTUnwrap(report.run(for: device.id))
+                XCTAssertEqual(run.report.latencies.count, 20)
+                XCTAssertTrue(run.table.indices.allSatisfy { run.table.stateCode(at: $0) == .success })
+                XCTAssertEqual(run.table.measurementsCount, 20)
+            }
+        }
+        
+        // the replicated table never ran
+        XCTAssertTrue(table.indices.allSatisfy { table.stateCode(at: $0) == .pending })
+        XCTAssertEqual(table.measurementsCount, 0)
+    }
+    
+    @MainActor
+    func testFailingDeviceDoesntStopTheOthers() async throws {
+        let failing = devices[0]
+        failing.setNextExpectedResponse(Data([0x6A, 0x82]))
+        
+        let report = await APDUFleetRunner().run(makeTable(count: 20), on: devices)
+        
+        XCTAssertEqual(report.failedRuns.map(\.deviceID), [failing.id])
+        XCTAssertEqual(report.run(for: failing.id)?.failedRow, 1)
+        XCTAssertEqual(report.run(for: failing.id)?.report.latencies.count, 1)
+        XCTAssertEqual(report.aggregate.latencies.count, UInt64(20 * (devices.count - 1) + 1))
+        XCTAssertGreaterThan(report.aggregate.throughput, report.run(for: devices[1].id)!.report.throughput)
+    }
+}
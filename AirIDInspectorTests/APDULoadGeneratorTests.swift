@@ -0,0 +1,74 @@
+//
+//  APDULoadGeneratorTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class APDULoadGeneratorTests: XCTestCase {
+    
+    func testSchedules() {
+        let fixed = Array(APDULoadGenerator(schedule: .fixedRate(perSecond: 100), duration: 1_000_000_000).arrivals(transactionSize: 5))
+        XCTAssertEqual(fixed.count, 100)
+        XCTAssertEqual(fixed[1] - fixed[0], 10_000_000)
+        
+        let bursts = Array(APDULoadGenerator(schedule: .bursts(size: 4, perSecond: 2), duration: 1_000_000_000).arrivals(transactionSize: 4))
+        XCTAssertEqual(bursts, [0, 0, 0, 0, 500_000_000, 500_000_000, 500_000_000, 500_000_000])
+        
+        // think time after every pass of 2 APDUs
+        let thinking = Array(APDULoadGenerator(schedule: .fixedRate(perSecond: 10), duration: 1_000_000_000, thinkTime: 200_000_000).arrivals(transactionSize: 2))
+        XCTAssertEqual(thinking, [0, 100_000_000, 400_000_000, 500_000_000, 800_000_000, 900_000_000])
+        
+        let poisson = APDULoadGenerator(schedule: .poisson(perSecond: 1_000), duration: 10_000_000_000, seed: 42)
+        let arrivals = Array(poisson.arrivals(transactionSize: 1))
+        XCTAssertEqual(Double(arrivals.count), 10_000, accuracy: 500)
+        XCTAssertEqual(arrivals, Array(poisson.arrivals(transactionSize: 1)))
+    }
+    
+    func testScheduleValidation() {
+        XCTAssertTrue(APDULoadGenerator.Schedule.bursts(size: 1, perSecond: 0.5).isValid)
+        XCTAssertFalse(APDULoadGenerator.Schedule.bursts(size: 0, perSecond: 2).isValid)
+        XCTAssertFalse(APDULoadGenerator.Schedule.fixedRate(perSecond: 0).isValid)
+        XCTAssertFalse(APDULoadGenerator.Schedule.poisson(perSecond: -1).isValid)
+        XCTAssertFalse(APDULoadGenerator.Schedule.fixedRate(perSecond: .infinity).isValid)
+        XCTAssertFalse(APDULoadGenerator.Schedule.poisson(perSecond: .nan).isValid)
+    }
+    
+    func testStallIsChargedToQueuedAPDUs() {
+        var report = APDULoadReport(schedule: .fixedRate(perSecond: 100))
+        var receivedAt: UInt64 = 0
+        
+        // every 10ms an APDU is due, the card takes 1ms except once it stalls for 100ms
+        for index in 0..<20 {
+            let intendedAt = UInt64(index) * 10_000_000
+            let sentAt = max(intendedAt, receivedAt)
+            receivedAt = sentAt + (index == 5 ? 100_000_000 : 1_000_000)
+            report.record(intendedAt: intendedAt, sentAt: sentAt, receivedAt: receivedAt, matches: true)
+        }
+        
+        // a closed loop only sees the one stall, the APDUs due during it waited too
+        XCTAssertEqual(report.service.maximum, 100_000_000)
+        XCTAssertEqual(report.lateCount, 10)
+        XCTAssertGreaterThan(report.corrected.percentile(0.9)!, 10 * report.service.percentile(0.9)!)
+    }
+    
+    @MainActor
+    func testOverloadedCardQueues() async throws {
+        let device = MockedDevice(id: UUID(), signalStrength: .medium, status: .connected)
+        device.responseDelay = 5_000_000...5_000_000
+        device.setNextExpectedResponse(Data([0x90, 0x00]))
+        let table = APDUOperationTable(entries: [.selectATR(nil), .test(command: "00B0000000".hexadecimal!, expectedResponse: "9000")])
+        
+        // twice what the card can answer
+        let generator = APDULoadGenerator(schedule: .fixedRate(perSecond: 400), duration: 200_000_000)
+        let report = try await generator.run(table, on: device)
+        
+        XCTAssertEqual(report.corrected.count, 80)
+        XCTAssertEqual(report.mismatchesCount, 0)
+        XCTAssertGreaterThan(report.lateCount, 0)
+        XCTAssertGreaterThan(report.corrected.percentile(0.99)!, report.service.percentile(0.99)!)
+    }
+}
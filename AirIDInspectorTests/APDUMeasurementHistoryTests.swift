@@ -0,0 +1,96 @@
+//
+//  APDUMeasurementHistoryTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class APDUMeasurementHistoryTests: XCTestCase {
+    
+    var fileURL: URL!
+    
+    override func setUpWithError() throws {
+        self.fileURL = FileManager.default.temporaryDirectory
+            .appendingPathComponent(UUID().uuidString)
+            .appendingPathComponent("measurements.history")
+    }
+    
+    override func tearDownWithError() throws {
+        try? FileManager.default.removeItem(at: fileURL.deletingLastPathComponent())
+    }
+    
+    func testPercentilesStayWithinBucketPrecision() {
+        let durations = (1...10_000).map { MeasurementNanoseconds($0) * 1_000 }
+        let histogram = APDULatencyHistogram(durations: durations)
+        
+        XCTAssertEqual(histogram.count, 10_000)
+        XCTAssertEqual(histogram.minimum, 1_000)
+        XCTAssertEqual(histogram.maximum, 10_000_000)
+        XCTAssertEqual(histogram.average, durations.reduce(0, +) / 10_000)
+        
+        for (fraction, exact) in [(0.5, 5_000_000.0), (0.9, 9_000_000.0), (0.99, 9_900_000.0)] {
+            let percentile = Double(histogram.percentile(fraction)!)
+            XCTAssertEqual(percentile, exact, accuracy: exact * 0.125)
+        }
+    }
+    
+    func testHistorySurvivesReopening() async throws {
+        let first = UUID()
+        let second = UUID()
+        
+        let history = APDUMeasurementHistory(fileURL: fileURL)
+        try await history.record([(first, 1_000), (first, 3_000), (second, 2_000)])
+        try await history.save()
+        
+        // another launch, another device, same operations
+        let reopened = APDUMeasurementHistory(fileURL: fileURL)
+        try await reopened.record([(first, 5_000)])
+        
+        let histogram = try await reopened.histogram(for: first)
+        XCTAssertEqual(histogram?.count, 3)
+        XCTAssertEqual(histogram?.minimum, 1_000)
+        XCTAssertEqual(histogram?.maximum, 5_000)
+        
+        let histograms = try await reopened.histograms(for: [second, UUID()])
+        XCTAssertEqual(histograms.keys.sorted { $0.uuidString < $1.uuidString }, [second])
+        XCTAssertEqual(histograms[second], APDULatencyHistogram(durations: [2_000]))
+    }
+    
+    func testMergingFoldedHistogramsMatchesRecording() async throws {
+        let identifier = UUID()
+        let durations = (1...1_000).map { MeasurementNanoseconds($0) * 7_000 }
+        
+        let recorded = APDUMeasurementHistory(fileURL: fileURL)
+        try await recorded.record(durations.map { (identifier, $0) })
+        
+        let merged = APDUMeasurementHistory(fileURL: fileURL.appendingPathExtension("merged"))
+        try await merged.merge([identifier: APDULatencyHistogram(durations: durations.prefix(400))])
+        try await merged.merge([identifier: APDULatencyHistogram(durations: durations.dropFirst(400)), UUID(): APDULatencyHistogram()])
+        
+        let expected = try await recorded.histogram(for: identifier)
+        let histogram = try await merged.histogram(for: identifier)
+        XCTAssertEqual(histogram, expected)
+    }
+    
+    func testDamagedHistoryIsMovedAside() async throws {
+        let damaged = Data("APDH".utf8) + Data([0x01, 0x00, 0x05])
+        try FileManager.default.createDirectory(at: fileURL.deletingLastPathComponent(), withIntermediateDirectories: true)
+        try damaged.write(to: fileURL)
+        
+        let history = APDUMeasurementHistory(fileURL: fileURL)
+        do {
+            _ = try await history.histogram(for: UUID())
+            XCTFail("a damaged history should be reported")
+        } catch { }
+        
+        // the history starts over, the damaged file is kept
+        try await history.record([(UUID(), 1_000)])
+        try await history.save()
+        
+        XCTAssertEqual(try Data(contentsOf: history.corruptFileURL), damaged)
+        XCTAssertNotEqual(try Data(contentsOf: fileURL), damaged)
+    }
+}
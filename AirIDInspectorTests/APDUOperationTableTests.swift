@@ -0,0 +1,184 @@
+//
+//  APDUOperationTableTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class APDUOperationTableTests: XCTestCase {
+    
+    var device: MockedDevice!
+    
+    override func setUpWithError() throws {
+        self.device = MockedDevice(id: UUID(),
+                                   signalStrength: .medium,
+                                   status: .initialized)
+    }
+    
+    func makeEntries(count: Int) -> [APDUScriptEntry] {
+        [.selectATR("3B00".hexadecimal), .setProtocol(.T1)] + (0..<count).map { index in
+            .test(command: "00B0\(String(format: "%04X", index % 100))00".hexadecimal!,
+                  expectedResponse: index.isMultiple(of: 2) ? "9000" : "6...")
+        }
+    }
+    
+    func testRowsMatchOperations() throws {
+        let entries = makeEntries(count: 300)
+        let table = APDUOperationTable(entries: entries)
+        let operations = entries.map { $0.operation(for: device) }
+        
+        XCTAssertEqual(table.count, operations.count)
+        XCTAssertEqual(table.indices.map { table.row(at: $0).name }, operations.map(\.name))
+        XCTAssertEqual(table.indices.map { table.type(at: $0) }, operations.map(\.type))
+        XCTAssertEqual(table.command(at: 5), (operations[5] as? APDUTestOperation)?.data)
+        
+        // commands and matchers are pooled
+        XCTAssertEqual(table.interningReport.operationsCount, 300)
+        XCTAssertEqual(table.interningReport.uniqueCommandsCount, 100)
+        XCTAssertEqual(table.interningReport.uniqueResponsesCount, 2)
+    }
+    
+    func testStatesAndStats() throws {
+        let table = APDUOperationTable(entries: makeEntries(count: 3))
+        
+        table.record(duration: 2_000_000, at: 2)
+        table.record(duration: 4_000_000, at: 2)
+        table.setState(.failed(.cancelled), at: 3)
+        table.setState(.success, at: 2)
+        
+        XCTAssertEqual(table.stateCode(at: 2), .success)
+        XCTAssertEqual(table.stateCode(at: 3), .failed)
+        XCTAssertEqual(table.stateCode(at: 4), .pending)
+        XCTAssertEqual(table.row(at: 2).description, APDUMeasurement(operationID: UUID(), durations: [2_000_000, 4_000_000]).description)
+        XCTAssertEqual(table.durationsByRow()[2], [2_000_000, 4_000_000])
+    }
+    
+    func testMaterializedOperationsRoundTrip() throws {
+        let table = APDUOperationTable(entries: makeEntries(count: 10))
+        table.record(duration: 1_000, at: 4)
+        table.setState(.success, at: 4)
+        
+        let operations = table.operations(for: device)
+        let imported = APDUOperationTable(operations: operations)
+        
+        XCTAssertEqual(imported.indices.map { imported.row(at: $0).name }, table.indices.map { table.row(at: $0).name })
+        XCTAssertEqual(imported.durationsByRow(), table.durationsByRow())
+        XCTAssertEqual(imported.stateCode(at: 4), .success)
+    }
+    
+    func testReloadKeepsUnchangedRows() throws {
+        let entries = makeEntries(count: 10)
+        let table = APDUOperationTable(entries: entries)
+        table.record(duration: 1_000, at: 3)
+        table.record(duration: 3_000, at: 8)
+        table.setState(.success, at: 8)
+        
+        // one pair edited, one inserted, one removed
+        var edited = entries
+        edited[5] = .test(command: "00A4040000".hexadecimal!, expectedResponse: "9000")
+        edited.insert(.test(command: "00CA7F6800".hexadecimal!, expectedResponse: "6A88"), at: 2)
+        edited.remove(at: 10)
+        
+        let reloaded = APDUOperationTable(entries: edited)
+        XCTAssertEqual(reloaded.inheritUnchangedRows(of: table), 10)
+        
+        XCTAssertEqual(reloaded.identifier(at: 4), table.identifier(at: 3))
+        XCTAssertEqual(reloaded.durationsByRow()[4], [1_000])
+        XCTAssertEqual(reloaded.durationsByRow()[9], [3_000])
+        XCTAssertEqual(reloaded.stateCode(at: 9), .success)
+        XCTAssertEqual(reloaded.durationsByRow()[2], [])
+        XCTAssertNotEqual(reloaded.identifier(at: 6), table.identifier(at: 5))
+    }
+    
+    func testIdentityDependsOnContentAndHeader() throws {
+        let entries = makeEntries(count: 4)
+        let table = APDUOperationTable(entries: entries)
+        
+        // the same pair elsewhere in another script keeps its id, on another device too
+        let shifted = APDUOperationTable(entries: [.selectATR("3B00".hexadecimal), .setProtocol(.T1)] + entries[4...] + entries[2..<4])
+        XCTAssertEqual(shifted.identifier(at: 4), table.identifier(at: 2))
+        
+        let interningTable = APDUInterningTable()
+        let operations = entries.map { $0.operation(for: device, interningTable: interningTable) }
+        XCTAssertEqual(operations.map(\.id), table.indices.map(table.identifier(at:)))
+        
+        // same command under another protocol isn't the same operation
+        let otherProtocol = APDUOperationTable(entries: [.selectATR("3B00".hexadecimal), .setProtocol(.T0)] + entries[2...])
+        XCTAssertNotEqual(otherProtocol.identifier(at: 2), table.identifier(at: 2))
+        
+        // and repeated pairs share their id
+        let repeated = APDUOperationTable(entries: makeEntries(count: 200))
+        XCTAssertEqual(repeated.identifier(at: 2), repeated.identifier(at: 102))
+        XCTAssertEqual(repeated.uniqueIdentifiers.count, 102)
+    }
+    
+    func testChangesAreCoalescedButEventsArent() throws {
+        let table = APDUOperationTable(entries: makeEntries(count: 1_000))
+        var events: [APDUOperationTable.RowEvent] = []
+        var publications = 0
+        let cancellables = [
+            table.events.sink { events.append($0) },
+            table.objectWillChange.sink { publications += 1 }
+        ]
+        
+        for row in table.indices {
+            table.setState(.running, at: row)
+            table.record(duration: 1_000, at: row)
+            table.setState(.success, at: row)
+        }
+        
+        // nothing reaches the views until the main queue turns
+        XCTAssertEqual(publications, 0)
+        XCTAssertEqual(events.count, table.count * 3)
+        
+        let published = expectation(description: "published")
+        DispatchQueue.main.asyncAfter(deadline: .now() + .milliseconds(50)) { published.fulfill() }
+        wait(for: [published], timeout: 1)
+        
+        XCTAssertEqual(publications, 1)
+        withExtendedLifetime(cancellables) { }
+    }
+    
+    @MainActor
+    func testWarmSessionSkipsMatchingHeader() async throws {
+        let table = APDUOperationTable(entries: [.selectATR(nil), .setProtocol(.T1)] + makeEntries(count: 2)[2...])
+        var report = APDURunReport()
+        var session = APDUCardSession()
+        XCTAssertFalse(session.isRedundant(0, of: table))
+        
+        for row in table.leadingHeaderRows {
+            let isRunning = await table.run(row, on: device, report: &report)
+            XCTAssertTrue(isRunning)
+            session.apply(row, of: table)
+        }
+        
+        XCTAssertEqual(table.leadingHeaderRows, 0..<2)
+        XCTAssertTrue(table.leadingHeaderRows.allSatisfy { session.isRedundant($0, of: table) })
+        XCTAssertEqual(report.latencies.count, 0)
+        
+        // another protocol, or a card expected to answer another ATR, needs the header again
+        let otherProtocol = APDUOperationTable(entries: [.selectATR(nil), .setProtocol(.T0)])
+        XCTAssertFalse(session.isRedundant(1, of: otherProtocol))
+        let otherCard = APDUOperationTable(entries: [.selectATR("3B00".hexadecimal)])
+        XCTAssertFalse(session.isRedundant(0, of: otherCard))
+    }
+    
+    func testPerformanceBuildingTable() {
+        let entries = makeEntries(count: 500_000)
+        
+        self.measure {
+            _ = APDUOperationTable(entries: entries)
+        }
+    }
+    
+    func testPerformanceBuildingOperations() {
+        let entries = makeEntries(count: 500_000)
+        
+        self.measure {
+            _ = entries.map { $0.operation(for: device) }
+        }
+    }
+}
@@ -0,0 +1,78 @@
+//
+//  APDUPipelinedRunnerTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class APDUPipelinedRunnerTests: XCTestCase {
+    
+    var device: MockedDevice!
+    
+    override func setUpWithError() throws {
+        self.device = MockedDevice(id: UUID(),
+                                   signalStrength: .medium,
+                                   status: .initialized)
+        device.responseDelay = 100_000...500_000
+        device.setNextExpectedResponse(Data([0x90, 0x00]))
+    }
+    
+    func makeTable(count: Int, expectedResponse: (Int) -> String = { _ in "9000" }) -> APDUOperationTable {
+        APDUOperationTable(entries: [.selectATR(nil)] + (0..<count).map { index in
+            .test(command: "00B0\(String(format: "%04X", index))00".hexadecimal!, expectedResponse: expectedResponse(index))
+        })
+    }
+    
+    @MainActor
+    func testPipelinedRunMatchesSerialRun() async throws {
+        let serial = makeTable(count: 50)
+        var serialReport = APDURunReport()
+        for row in serial.indices {
+            guard await serial.run(row, on: device, report: &serialReport) else { break }
+        }
+        
+        let pipelined = makeTable(count: 50)
+        var pipelinedReport = APDURunReport()
+        let isRunning = await APDUPipelinedRunner(batchSize: 4, publishInterval: 0).run(pipelined, rows: pipelined.indices, on: device, report: &pipelinedReport)
+        
+        XCTAssertTrue(isRunning)
+        XCTAssertEqual(pipelined.indices.map(pipelined.stateCode(at:)), serial.indices.map(serial.stateCode(at:)))
+        XCTAssertEqual(pipelinedReport.latencies.count, 50)
+        XCTAssertEqual(pipelinedReport.gaps.count, 49)
+        XCTAssertEqual(pipelined.durationsByRow().map(\.count), serial.durationsByRow().map(\.count))
+    }
+    
+    @MainActor
+    func testMismatchStopsWithinOneBatch() async throws {
+        let table = makeTable(count: 40) { $0 == 10 ? "6A82" : "9000" }
+        var report = APDURunReport()
+        
+        let isRunning = await APDUPipelinedRunner(batchSize: 4).run(table, rows: table.indices, on: device, report: &report)
+        
+        XCTAssertFalse(isRunning)
+        XCTAssertEqual(table.stateCode(at: 11), .failed)
+        
+        // the rest of the failing batch (rows 9 to 12) ran, nothing after it
+        XCTAssertEqual(table.stateCode(at: 12), .success)
+        XCTAssertTrue(table.indices.dropFirst(13).allSatisfy { table.stateCode(at: $0) == .pending })
+        XCTAssertEqual(table.durationsByRow().dropFirst(13).map(\.count), Array(repeating: 0, count: table.count - 13))
+        XCTAssertFalse(table.indices.contains { table.stateCode(at: $0) == .running })
+    }
+    
+    @MainActor
+    func testMismatchStopsLikeSerialWithBatchSizeOne() async throws {
+        let table = makeTable(count: 20) { $0 == 10 ? "6A82" : "9000" }
+        var report = APDURunReport()
+        
+        let isRunning = await APDUPipelinedRunner(batchSize: 1).run(table, rows: table.indices, on: device, report: &report)
+        
+        XCTAssertFalse(isRunning)
+        XCTAssertEqual(table.stateCode(at: 11), .failed)
+        XCTAssertEqual(report.latencies.count, 11)
+        XCTAssertTrue(table.indices.dropFirst(12).allSatisfy { table.stateCode(at: $0) == .pending })
+        XCTAssertTrue(table.durationsByRow().dropFirst(12).allSatisfy(\.isEmpty))
+    }
+}
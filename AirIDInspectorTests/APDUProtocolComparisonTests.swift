@@ -0,0 +1,66 @@
+//
+//  APDUProtocolComparisonTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class APDUProtocolComparisonTests: XCTestCase {
+    
+    /// A card slower under T=0, answering GET DATA differently under either protocol.
+    private final class ProtocolCard: MockedDevice {
+        private(set) var selectedProtocols: [AIPCardProtocol] = []
+        
+        override func selectProtocol(cardProtocol: AIPCardProtocol) async throws {
+            selectedProtocols.append(cardProtocol)
+        }
+        
+        override func sendAPDU(with data: Data) async throws -> Data {
+            let cardProtocol = selectedProtocols.last ?? .T1
+            try await Task.sleep(nanoseconds: cardProtocol == .T0 ? 3_000_000 : 1_000_000)
+            
+            if data[1] == 0xCA {
+                return Data([cardProtocol == .T0 ? 0x00 : 0x01, 0x90, 0x00])
+            }
+            
+            return Data([0x90, 0x00])
+        }
+    }
+    
+    private var device: ProtocolCard!
+    
+    override func setUpWithError() throws {
+        device = ProtocolCard(id: UUID(), signalStrength: .medium, status: .connected)
+    }
+    
+    @MainActor
+    func testProtocolsAreComparedOnTheSameAPDUs() async throws {
+        let table = APDUOperationTable(entries: [.selectATR(nil), .setProtocol(.T1),
+                                                 .test(command: "00A4040000".hexadecimal!, expectedResponse: "9000"),
+                                                 .test(command: "80CA9F7F00".hexadecimal!, expectedResponse: "9000")])
+        
+        let report = try await APDUProtocolComparison(rounds: 4).run(table, on: device)
+        
+        XCTAssertEqual(device.selectedProtocols, [.T0, .T1, .T1, .T0, .T1, .T0, .T0, .T1])
+        XCTAssertEqual(report.rows, [2, 3])
+        XCTAssertEqual(report.t0.totals.count, 4)
+        XCTAssertEqual(report.t1.latencies.map(\.count), [4, 4])
+        XCTAssertLessThan(report.totalDelta, 0)
+        XCTAssertEqual(report.differences, [.init(row: 3, t0: "009000".hexadecimal!, t1: "019000".hexadecimal!)])
+    }
+    
+    @MainActor
+    func testRequestedProtocolIsSelected() async throws {
+        let table = APDUOperationTable(entries: [.setProtocol(.T0)])
+        
+        var report = APDURunReport()
+        
+        let isCompleted = await table.run(0, on: device, report: &report)
+        
+        XCTAssertTrue(isCompleted)
+        XCTAssertEqual(device.selectedProtocols, [.T0])
+    }
+}
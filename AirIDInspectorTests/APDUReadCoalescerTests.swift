@@ -0,0 +1,106 @@
+//
+//  APDUReadCoalescerTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class APDUReadCoalescerTests: XCTestCase {
+    
+    /// A card with a single transparent file, declaring extended lengths in its ATR.
+    private final class FileCard: MockedDevice {
+        let file = Data((0..<1024).map { UInt8($0 % 251) })
+        var atr = "3B858001807300004000".hexadecimal!
+        private(set) var commands: [Data] = []
+        
+        override func wakeUp() async throws -> Data {
+            atr
+        }
+        
+        override func sendAPDU(with data: Data) async throws -> Data {
+            commands.append(data)
+            guard let command = APDUCommand(data), command.header[1] == 0xB0 else { return Data([0x90, 0x00]) }
+            
+            let offset = Int(command.header[2]) << 8 | Int(command.header[3])
+            let end = min(offset + (command.expectedLength ?? 0), file.count)
+            return file[offset..<end] + Data([0x90, 0x00])
+        }
+    }
+    
+    private var device: FileCard!
+    
+    override func setUpWithError() throws {
+        device = FileCard(id: UUID(), signalStrength: .medium, status: .connected)
+        device.linkLimits = APDULinkLimits(commandSize: 266, responseSize: 1026)
+    }
+    
+    private func read(_ offset: Int, _ length: Int, expected: String? = nil) -> APDUScriptEntry {
+        let expected = expected ?? device.file[offset..<offset + length].hexEncodedString() + "9000"
+        return .test(command: Data([0x00, 0xB0, UInt8(offset >> 8), UInt8(offset & 0xFF), UInt8(length)]), expectedResponse: expected)
+    }
+    
+    private func makeTable(expectedAt0x100: String? = nil) -> APDUOperationTable {
+        APDUOperationTable(entries: [.selectATR(nil),
+                                     read(0x000, 0x80), read(0x080, 0x80), read(0x100, 0x80, expected: expectedAt0x100), read(0x180, 0x80),
+                                     read(0x300, 0x10),
+                                     .test(command: "00A4040000".hexadecimal!, expectedResponse: "9000")])
+    }
+    
+    func testCapabilitiesAreReadFromTheATR() {
+        XCTAssertTrue(APDUCardCapabilities(atr: "3B858001807300004000".hexadecimal!).supportsExtendedLength)
+        XCTAssertFalse(APDUCardCapabilities(atr: "3B858001807300000000".hexadecimal!).supportsExtendedLength)
+        XCTAssertFalse(APDUCardCapabilities(atr: "3B00".hexadecimal!).supportsExtendedLength)
+        XCTAssertFalse(APDUCardCapabilities(atr: Data()).supportsExtendedLength)
+    }
+    
+    func testContiguousReadsArePlanned() {
+        let table = makeTable()
+        let reads = (1...4).map { APDUReadCoalescer.read(at: $0, of: table)! }
+        
+        XCTAssertEqual(APDUReadCoalescer.plan(table, rows: table.indices, maximumLength: 1024),
+                       [.row(0), .merged(reads), .row(5), .row(6)])
+        XCTAssertEqual(APDUReadCoalescer.plan(table, rows: table.indices, maximumLength: 256),
+                       [.row(0), .merged(Array(reads[0...1])), .merged(Array(reads[2...3])), .row(5), .row(6)])
+        XCTAssertEqual(APDUReadCoalescer.plan(table, rows: table.indices, maximumLength: 0), table.indices.map { .row($0) })
+    }
+    
+    @MainActor
+    func testMergedReadsAreCheckedRowByRow() async {
+        let table = makeTable()
+        var report = APDURunReport()
+        
+        let isCompleted = await APDUTestsViewModel.ExecutionMode.coalesced.run(table, rows: table.indices, on: device, report: &report)
+        
+        XCTAssertTrue(isCompleted)
+        XCTAssertEqual(device.commands.first, "00B00000000200".hexadecimal!)
+        XCTAssertEqual(device.commands.count, 3)
+        XCTAssertTrue(table.indices.allSatisfy { table.stateCode(at: $0) == .success })
+        XCTAssertEqual(table.durationsByRow()[1...4].map(\.count), [1, 1, 1, 1])
+    }
+    
+    @MainActor
+    func testMismatchStopsAtItsRow() async {
+        let table = makeTable(expectedAt0x100: "6A82")
+        var report = APDURunReport()
+        
+        let isCompleted = await APDUTestsViewModel.ExecutionMode.coalesced.run(table, rows: table.indices, on: device, report: &report)
+        
+        XCTAssertFalse(isCompleted)
+        XCTAssertEqual((1...4).map { table.stateCode(at: $0) }, [.success, .success, .failed, .pending])
+    }
+    
+    @MainActor
+    func testReadsArentMergedWithoutExtendedLengths() async {
+        device.atr = "3B00".hexadecimal!
+        let table = makeTable()
+        var report = APDURunReport()
+        
+        let isCompleted = await APDUTestsViewModel.ExecutionMode.coalesced.run(table, rows: table.indices, on: device, report: &report)
+        
+        XCTAssertTrue(isCompleted)
+        XCTAssertEqual(device.commands.count, 6)
+    }
+}
@@ -0,0 +1,106 @@
+//
+//  APDUResponseMatcherTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class APDUResponseMatcherTests: XCTestCase {
+    
+    let responses: [Data] = ["9000", "6A82", "6000", "019000", "6F1A840E315041592E5359532E4444463031A5088801025F2D02656E9000", "", "0A"]
+        .map { $0.hexadecimal ?? Data() }
+    
+    func testNibblePatternsMatchRegex() {
+        let patterns = ["9000", "6...", "^6F", "9000$", "^6A82$", "..", "0", "A.", "19", "^..$", "9.00$", "6a82"]
+        
+        for pattern in patterns {
+            let matcher = APDUResponseMatcher(expectedResponse: pattern)
+            XCTAssertEqual(matcher.kind, pattern == "6a82" ? .regex : .nibbles, pattern)
+            
+            for response in responses {
+                let expected = response.hexEncodedString().range(of: pattern, options: .regularExpression) != nil
+                XCTAssertEqual(matcher.matches(response), expected, "\(pattern) ~ \(response.hexEncodedString())")
+            }
+        }
+    }
+    
+    func testRegexFallback() {
+        let matcher = APDUResponseMatcher(expectedResponse: "(9000|6A8[0-9])$")
+        
+        XCTAssertEqual(matcher.kind, .regex)
+        XCTAssertTrue(matcher.matches("6A82".hexadecimal!))
+        XCTAssertFalse(matcher.matches("6D00".hexadecimal!))
+        XCTAssertFalse(APDUResponseMatcher(expectedResponse: "(9000").matches("9000".hexadecimal!))
+    }
+    
+    func testHexResponsesWithoutRegex() {
+        let statusWord = APDUResponseMatcher(expectedResponse: "9000", options: [])
+        XCTAssertEqual(statusWord.kind, .statusWord)
+        XCTAssertTrue(statusWord.matches("01029000".hexadecimal!))
+        XCTAssertFalse(statusWord.matches("90000102".hexadecimal!))
+        
+        let bytes = APDUResponseMatcher(expectedResponse: "01029000", options: [])
+        XCTAssertEqual(bytes.kind, .bytes)
+        XCTAssertTrue(bytes.matches("01029000".hexadecimal!))
+        XCTAssertFalse(bytes.matches("0001029000".hexadecimal!))
+    }
+    
+    func testFailures() {
+        XCTAssertNil(APDUResponseMatcher(expectedResponse: "9000").failure(for: "9000".hexadecimal!))
+        
+        guard case .invalidResponse(let actual, _) = APDUResponseMatcher(expectedResponse: "6...").failure(for: "01029000".hexadecimal!) else {
+            return XCTFail("expected an invalid response")
+        }
+        XCTAssertEqual(actual, "9000".hexadecimal)
+        
+        // bytes are compared as a whole, so the whole response is reported
+        guard case .invalidResponse(let bytes, _) = APDUResponseMatcher(expectedResponse: "01029000", options: []).failure(for: "03049000".hexadecimal!) else {
+            return XCTFail("expected an invalid response")
+        }
+        XCTAssertEqual(bytes, "03049000".hexadecimal)
+        
+        guard case .serializationError = APDUResponseMatcher(expectedResponse: "90XX", options: []).failure(for: "9000".hexadecimal!) else {
+            return XCTFail("expected a serialization error")
+        }
+    }
+    
+    func testPerformanceNibblePatterns() {
+        let matchers = ["9000", "6...", "^6F", "9000$", "^6F1A840E315041592E5359532E4444463031A5088801025F2D02656E9000$"]
+            .map { APDUResponseMatcher(expectedResponse: $0) }
+        
+        self.measure {
+            for _ in 0..<20_000 {
+                for matcher in matchers {
+                    responses.forEach { _ = matcher.matches($0) }
+                }
+            }
+        }
+    }
+    
+    func testPerformanceRegexFallback() {
+        let matchers = ["(9000|6A8[0-9])$", "^6F[0-9A-F]+9000$"].map { APDUResponseMatcher(expectedResponse: $0) }
+        
+        self.measure {
+            for _ in 0..<20_000 {
+                for matcher in matchers {
+                    responses.forEach { _ = matcher.matches($0) }
+                }
+            }
+        }
+    }
+    
+    func testPerformanceUncompiledRegex() {
+        let patterns = ["9000", "6...", "^6F", "9000$", "(9000|6A8[0-9])$"]
+        
+        self.measure {
+            for _ in 0..<20_000 {
+                for pattern in patterns {
+                    responses.forEach { _ = $0.hexEncodedString().range(of: pattern, options: .regularExpression) }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,249 @@
+//
+//  APDUScriptParserTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class APDUScriptParserTests: XCTestCase {
+    
+    let APDUTest = """
+    T=1
+    ATR:3B8F8001804F0CA000000306030001000000006A
+    # select the application
+    00A404000BA0000003974349445F0100
+    6a82
+    
+    00CA7F6800\r
+    6a88
+    00A4040009A00000030800001000
+    """
+    
+    var device: MockedDevice!
+    var fileURL: URL!
+    
+    override func setUpWithError() throws {
+        self.device = MockedDevice(id: UUID(),
+                                   signalStrength: .medium,
+                                   status: .initialized)
+        
+        self.fileURL = FileManager.default.temporaryDirectory.appendingPathComponent("\(UUID().uuidString).txt")
+        try APDUTest.write(to: fileURL, atomically: true, encoding: .utf8)
+    }
+    
+    override func tearDownWithError() throws {
+        try? FileManager.default.removeItem(at: fileURL)
+    }
+    
+    func testHeadersCommentsAndPairs() throws {
+        let operations = try APDUTestSourceString(string: APDUTest).getAPDUTestOperations(for: device)
+        
+        XCTAssertEqual(operations.map(\.type), [.selectATR, .setProtocol, .apduTest, .apduTest])
+        XCTAssertEqual((operations[0] as? APDUSelectATROperation)?.atrData, "3B8F8001804F0CA000000306030001000000006A".hexadecimal)
+        XCTAssertEqual((operations[3] as? APDUTestOperation)?.expectedResponse, "6a88")
+    }
+    
+    func testStreamMatchesString() async throws {
+        let expected = try APDUTestSourceString(string: APDUTest).getAPDUTestOperations(for: device)
+        
+        // a tiny block size forces lines to span several reads
+        var streamed: [APDUBaseOperation] = []
+        for try await operation in APDUTestOperationStream(fileURL: fileURL, device: device, blockSize: 7) {
+            streamed.append(operation)
+        }
+        
+        XCTAssertEqual(streamed.map(\.name), expected.map(\.name))
+        XCTAssertEqual(streamed.compactMap { ($0 as? APDUTestOperation)?.expectedResponse },
+                       expected.compactMap { ($0 as? APDUTestOperation)?.expectedResponse })
+    }
+    
+    func testCompiledScriptSeeksToOperation() throws {
+        let script = (0..<1_000).map { "00B0\(String(format: "%04X", $0))00\n9000" }.joined(separator: "\n")
+        let compiledURL = fileURL.appendingPathExtension(APDUCompiledScriptFormat.fileExtension)
+        defer { try? FileManager.default.removeItem(at: compiledURL) }
+        
+        XCTAssertEqual(try APDUScriptCompiler(indexStride: 64).compile(string: "T=0\n" + script, to: compiledURL), 1_000)
+        
+        let compiled = try APDUCompiledScript(url: compiledURL)
+        XCTAssertEqual(compiled.count, 1_000)
+        XCTAssertEqual(compiled.cardProtocol, .T0)
+        
+        var cursor = try compiled.cursor(at: 700)
+        guard case .test(let command, let expectedResponse) = try cursor.next() else {
+            return XCTFail("expected a test record")
+        }
+        
+        XCTAssertEqual(command.hexEncodedString(), "00B002BC00")
+        XCTAssertEqual(expectedResponse, "9000")
+        
+        let operations = try APDUTestSourceCompiled(url: compiledURL, range: 10..<20).getAPDUTestOperations(for: device)
+        XCTAssertEqual(operations.map(\.type), [.selectATR, .setProtocol] + Array(repeating: .apduTest, count: 10))
+        XCTAssertEqual(operations[2].name, "00B0000A00")
+    }
+    
+    func testCompiledRecordsKeepTheirMatchers() throws {
+        let responses = ["9000", "^6...$", "9000$", "6[AB]82", "6a82", "xyz"]
+        let script = responses.map { "00A4040000\n\($0)" }.joined(separator: "\n")
+        let compiledURL = fileURL.appendingPathExtension(APDUCompiledScriptFormat.fileExtension)
+        defer { try? FileManager.default.removeItem(at: compiledURL) }
+        
+        try APDUScriptCompiler(indexStride: 2).compile(string: script, to: compiledURL)
+        
+        // seeking skips the matchers of the records before
+        var cursor = try APDUCompiledScript(url: compiledURL).cursor(at: 1)
+        for (expectedResponse, response) in zip(responses.dropFirst(), ["6A82", "019000", "6B82", "6A82", "9000"].map { $0.hexadecimal! }) {
+            let matcher = try XCTUnwrap(cursor.nextRecord()).matcher
+            let text = APDUResponseMatcher(expectedResponse: expectedResponse)
+            
+            XCTAssertEqual(matcher.expectedResponse, expectedResponse)
+            XCTAssertEqual(matcher.kind, text.kind, expectedResponse)
+            XCTAssertEqual(matcher.matches(response), text.matches(response), expectedResponse)
+        }
+    }
+    
+    func testDamagedCompiledScriptThrows() throws {
+        let compiledURL = fileURL.appendingPathExtension(APDUCompiledScriptFormat.fileExtension)
+        defer { try? FileManager.default.removeItem(at: compiledURL) }
+        
+        try APDUScriptCompiler(indexStride: 1).compile(string: "00A4040000\n9000\n00B0000000\n9000", to: compiledURL)
+        let original = try Data(contentsOf: compiledURL)
+        
+        // a failed compile leaves the existing script in place
+        XCTAssertThrowsError(try APDUScriptCompiler().compile(string: "BEGIN TRANSACTION\n00A4040000\n9000", to: compiledURL))
+        XCTAssertEqual(try Data(contentsOf: compiledURL), original)
+        
+        // count, index offset and index entries far past the file
+        for (offset, value) in [(16, UInt64.max), (24, UInt64.max - 4), (24, UInt64(Int.max)), (APDUCompiledScriptFormat.headerSize, UInt64.max)] {
+            var damaged = original
+            damaged.replaceSubrange(offset..<offset + 8, with: Swift.withUnsafeBytes(of: value.littleEndian) { Data($0) })
+            try damaged.write(to: compiledURL)
+            
+            XCTAssertThrowsError(try APDUTestSourceCompiled(url: compiledURL).getAPDUTestOperations(for: device), "\(offset)")
+        }
+    }
+    
+    func testParallelParsingMatchesSequential() async throws {
+        // comments and blank lines shift the pair boundaries away from the chunk boundaries
+        let body = (0..<50_000).map { index in
+            let pair = "00B0\(String(format: "%04X", index % 0xFFFF))00\n\(index.isMultiple(of: 7) ? "6A82" : "9000")"
+            return index.isMultiple(of: 5) ? "# pair \(index)\n\n" + pair : pair
+        }.joined(separator: "\n")
+        let script = "T=1\nATR:3B00\n" + body
+        
+        let sequential = try APDUTestSourceString(string: script, parsingMode: .sequential).getAPDUTestOperations(for: device)
+        let parallel = try await APDUParallelScriptParser.operations(in: script, for: device, maximumChunks: 13)
+        
+        XCTAssertEqual(parallel.map(\.type), sequential.map(\.type))
+        XCTAssertEqual(parallel.map(\.name), sequential.map(\.name))
+        XCTAssertEqual(parallel.compactMap { ($0 as? APDUTestOperation)?.expectedResponse },
+                       sequential.compactMap { ($0 as? APDUTestOperation)?.expectedResponse })
+        
+        // a table is filled from the entries, with the same rows
+        let sequentialTable = try await APDUTestSourceString(string: script, parsingMode: .sequential).loadAPDUOperationTable(for: device)
+        let parallelTable = try await APDUTestSourceString(string: script, parsingMode: .parallel).loadAPDUOperationTable(for: device)
+        XCTAssertEqual(parallelTable.indices.map(parallelTable.identifier(at:)), sequentialTable.indices.map(sequentialTable.identifier(at:)))
+    }
+    
+    func testPerformanceSequentialParsing() throws {
+        let script = Self.millionLineScript
+        self.measure {
+            _ = try? APDUTestSourceString(string: script, parsingMode: .sequential).getAPDUTestOperations(for: device)
+        }
+    }
+    
+    func testPerformanceParallelParsing() throws {
+        let script = Self.millionLineScript
+        self.measure {
+            let parsed = expectation(description: "parsed")
+            Task {
+                _ = try? await APDUTestSourceString(string: script, parsingMode: .parallel).loadAPDUTestOperations(for: device)
+                parsed.fulfill()
+            }
+            
+            wait(for: [parsed], timeout: 120)
+        }
+    }
+    
+    static let millionLineScript = (0..<500_000).map { index in
+        "00A4040009A000000308\(String(format: "%08X", index))\n9000"
+    }.joined(separator: "\n")
+    
+    func testRepeatedPayloadsAreInterned() throws {
+        let script = (0..<1_000).map { index in
+            "00A4040010A000000308000010000000\(index % 4)0\n\(index.isMultiple(of: 2) ? "9000" : "6A82")"
+        }.joined(separator: "\n")
+        
+        let source = APDUTestSourceString(string: script, parsingMode: .sequential)
+        let operations = try source.getAPDUTestOperations(for: device).compactMap { $0 as? APDUTestOperation }
+        
+        XCTAssertEqual(source.interningReport?.operationsCount, 1_000)
+        XCTAssertEqual(source.interningReport?.uniqueCommandsCount, 4)
+        XCTAssertEqual(source.interningReport?.uniqueResponsesCount, 2)
+        XCTAssertEqual(source.interningReport?.commandsRatio, 250)
+        
+        // same payload, same storage, the commands are long enough not to be stored inline
+        operations[0].data.withUnsafeBytes { first in
+            operations[4].data.withUnsafeBytes { second in
+                XCTAssertEqual(first.baseAddress, second.baseAddress)
+            }
+        }
+    }
+    
+    func testRepeatBlocksAreExpanded() async throws {
+        let script = """
+        T=1
+        REPEAT 3
+        00A4040000
+        9000
+        REPEAT 2
+        00B0000000
+        9000
+        END
+        END
+        00CA7F6800
+        6A88
+        """
+        
+        let names = try APDUTestSourceString(string: script).getAPDUTestOperations(for: device).map(\.name)
+        let block = ["00A4040000", "00B0000000", "00B0000000"]
+        XCTAssertEqual(names, ["Selecting ATR..", "Set Protocol.."] + block + block + block + ["00CA7F6800"])
+        
+        // the outline keeps every pair once
+        let source = APDUTestSourceString(string: script, parsingMode: .sequential)
+        let table = try await source.loadAPDUOperationTable(for: device)
+        XCTAssertEqual(table.count, 5)
+        XCTAssertTrue(source.containsDirectives)
+    }
+    
+    func testIncludeIsResolvedAgainstTheIncludingScript() throws {
+        let directory = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString)
+        try FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true)
+        defer { try? FileManager.default.removeItem(at: directory) }
+        
+        // the header of the included script is ignored
+        try "T=0\n00A4040000\n9000\n".write(to: directory.appendingPathComponent("select.txt"), atomically: true, encoding: .utf8)
+        let mainURL = directory.appendingPathComponent("main.txt")
+        try "REPEAT 2\nINCLUDE select.txt\n00B0000000\n9000\nEND\n".write(to: mainURL, atomically: true, encoding: .utf8)
+        
+        let names = try APDUScriptFileReader(fileURL: mainURL).readAll(for: device).map(\.name)
+        XCTAssertEqual(names, ["Selecting ATR..", "00A4040000", "00B0000000", "00A4040000", "00B0000000"])
+    }
+    
+    func testIncludeCycleIsRejected() throws {
+        try "00A4040000\n9000\nINCLUDE \(fileURL.lastPathComponent)\n".write(to: fileURL, atomically: true, encoding: .utf8)
+        XCTAssertThrowsError(try APDUScriptFileReader(fileURL: fileURL).readAll(for: device)) { error in
+            XCTAssertTrue(error is APDUScriptDirective.InvalidDirectiveError)
+        }
+    }
+    
+    func testUnterminatedRepeatIsInvalid() {
+        XCTAssertThrowsError(try APDUTestSourceString(string: "REPEAT 2\n00A4040000\n9000\n").getAPDUTestOperations(for: device))
+    }
+    
+    func testEmptyScriptIsInvalid() {
+        XCTAssertThrowsError(try APDUTestSourceString(string: "T=0\n# nothing\n").getAPDUTestOperations(for: device))
+    }
+}
@@ -0,0 +1,85 @@
+//
+//  APDUShardedRunnerTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class APDUShardedRunnerTests: XCTestCase {
+    
+    var devices: [MockedDevice]!
+    
+    override func setUpWithError() throws {
+        self.devices = (0..<3).map { _ in
+            let device = MockedDevice(id: UUID(), signalStrength: .medium, status: .connected)
+            device.responseDelay = 100_000...200_000
+            device.setNextExpectedResponse(Data([0x90, 0x00]))
+            return device
+        }
+    }
+    
+    func makeUnits(count: Int, expectedResponse: (Int) -> String = { _ in "9000" }) -> [APDUOperationTable] {
+        (0..<count).map { unit in
+            APDUOperationTable(entries: [.selectATR(nil)] + (0..<5).map { index in
+                .test(command: "00B0\(String(format: "%02X%02X", unit, index))00".hexadecimal!, expectedResponse: expectedResponse(unit))
+            })
+        }
+    }
+    
+    @MainActor
+    func testFasterDevicesPullMoreUnits() async throws {
+        devices[0].responseDelay = 2_000_000...2_000_000
+        let units = makeUnits(count: 30)
+        
+        let report = await APDUShardedRunner().run(units, on: devices)
+        
+        XCTAssertEqual(report.completedCount, 30)
+        XCTAssertEqual(report.workers.flatMap(\.completedUnits).sorted(), Array(0..<30))
+        XCTAssertLessThan(report.worker(for: devices[0].id)!.completedUnits.count, report.worker(for: devices[1].id)!.completedUnits.count)
+        XCTAssertEqual(report.aggregate.latencies.count, 30 * 5)
+    }
+    
+    @MainActor
+    func testDroppedDeviceRequeuesItsUnit() async throws {
+        devices[0].disconnectsAfter = 7
+        let units = makeUnits(count: 10)
+        
+        let report = await APDUShardedRunner().run(units, on: devices)
+        
+        XCTAssertEqual(report.completedCount, 10)
+        XCTAssertTrue(report.pendingUnits.isEmpty)
+        XCTAssertNotNil(report.worker(for: devices[0].id)?.error)
+        XCTAssertEqual(report.worker(for: devices[0].id)?.completedUnits.count, 1)
+        
+        // the interrupted unit ran again from the start on another device
+        for table in units {
+            XCTAssertTrue(table.indices.allSatisfy { table.stateCode(at: $0) == .success })
+        }
+    }
+    
+    @MainActor
+    func testMismatchFailsOnlyItsUnit() async throws {
+        let units = makeUnits(count: 10) { $0 == 4 ? "6A82" : "9000" }
+        
+        let report = await APDUShardedRunner(executionMode: .pipelined).run(units, on: devices)
+        
+        XCTAssertEqual(report.failedUnits, [4])
+        XCTAssertEqual(report.completedCount, 9)
+        XCTAssertTrue(report.workers.allSatisfy { $0.error == nil })
+    }
+    
+    @MainActor
+    func testUnitsAreLeftPendingWithoutDevices() async throws {
+        devices.forEach { $0.disconnectsAfter = 0 }
+        let units = makeUnits(count: 4)
+        
+        let report = await APDUShardedRunner().run(units, on: devices)
+        
+        XCTAssertEqual(report.completedCount, 0)
+        XCTAssertEqual(report.pendingUnits, [0, 1, 2, 3])
+        XCTAssertTrue(report.workers.allSatisfy { $0.error != nil })
+    }
+}
@@ -0,0 +1,139 @@
+//
+//  APDUSnapshotCodecTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class APDUSnapshotCodecTests: XCTestCase {
+    
+    var device: MockedDevice!
+    
+    override func setUpWithError() throws {
+        self.device = MockedDevice(id: UUID(),
+                                   signalStrength: .medium,
+                                   status: .initialized)
+    }
+    
+    /// A snapshot with a large measurement history, as after long runs.
+    func makeOperations(count: Int, durationsCount: Int) -> [APDUBaseOperation] {
+        var operations: [APDUBaseOperation] = [
+            APDUSelectATROperation(device: device, name: "Select ATR..", atrData: "3B00".hexadecimal),
+            APDUSetProtocolOperation(device: device, name: "Set Protocol..", protocol: .T1)
+        ]
+        
+        for index in 0..<count {
+            let operation = APDUTestOperation(device: device,
+                                              data: "00B0\(String(format: "%04X", index))00".hexadecimal!,
+                                              expectedResponse: index.isMultiple(of: 2) ? "9000" : "6...")
+            (0..<durationsCount).forEach { operation.measurements.append(duration: 4_000_000 + UInt64($0 % 97) * 1_337) }
+            operations.append(operation)
+        }
+        
+        operations[2].state = .failed(.invalidResponse("6A82".hexadecimal!, "9000".hexadecimal!))
+        return operations
+    }
+    
+    func testBinaryRoundTrip() throws {
+        let operations = makeOperations(count: 20, durationsCount: 50)
+        let data = try APDUTestSourceSnapshot.data(for: operations, deviceIdentifier: device.id)
+        
+        XCTAssertTrue(APDUSnapshotFormat.isSnapshot(data))
+        
+        let decoded = try APDUTestSourceSnapshot(data: data).getAPDUTestOperations(for: device)
+        
+        XCTAssertEqual(decoded.map(\.id), operations.map(\.id))
+        XCTAssertEqual(decoded.map(\.type), operations.map(\.type))
+        XCTAssertEqual(decoded.map(\.name), operations.map(\.name))
+        XCTAssertEqual(decoded.map(\.measurements.durations), operations.map(\.measurements.durations))
+        XCTAssertEqual(decoded.map(\.state.name), operations.map(\.state.name))
+        XCTAssertEqual((decoded[0] as? APDUSelectATROperation)?.atrData, "3B00".hexadecimal)
+        XCTAssertEqual((decoded[3] as? APDUTestOperation)?.expectedResponse, "6...")
+    }
+    
+    func testBinarySnapshotRestoresIntoTable() async throws {
+        let operations = makeOperations(count: 20, durationsCount: 50)
+        let data = try APDUTestSourceSnapshot.data(for: operations, deviceIdentifier: device.id)
+        
+        let table = try await APDUTestSourceSnapshot(data: data).loadAPDUOperationTable(for: device)
+        
+        XCTAssertEqual(table.count, operations.count)
+        XCTAssertEqual(table.indices.map(table.type(at:)), operations.map(\.type))
+        XCTAssertEqual(table.durationsByRow(), operations.map(\.measurements.durations))
+        XCTAssertEqual(table.indices.map { table.state(at: $0).name }, operations.map(\.state.name))
+    }
+    
+    func testDurationsDecodeWithoutOperations() throws {
+        let operations = makeOperations(count: 5, durationsCount: 10)
+        operations[4].measurements.append(duration: 0)
+        operations[4].measurements.append(duration: .max)
+        
+        let archive = try APDUSnapshotArchive(data: APDUSnapshotFormat.encode(operations, deviceIdentifier: device.id))
+        
+        XCTAssertEqual(archive.count, operations.count)
+        XCTAssertEqual(archive.deviceIdentifier, device.id)
+        XCTAssertEqual(try archive.durations(at: 4), operations[4].measurements.durations)
+        XCTAssertEqual(try archive.durations(at: 0), [])
+    }
+    
+    func testJSONExportRoundTrip() throws {
+        let operations = makeOperations(count: 3, durationsCount: 3)
+        let data = try APDUTestSourceSnapshot.data(for: operations, deviceIdentifier: device.id, format: .json)
+        
+        let decoded = try APDUTestSourceSnapshot(data: data).getAPDUTestOperations(for: device)
+        XCTAssertEqual(decoded.map(\.measurements.durations), operations.map(\.measurements.durations))
+    }
+    
+    func testCorruptedSnapshotThrows() throws {
+        var data = APDUSnapshotFormat.encode(makeOperations(count: 2, durationsCount: 2), deviceIdentifier: device.id)
+        data.removeLast()
+        
+        XCTAssertThrowsError(try APDUSnapshotArchive(data: data))
+    }
+    
+    func testDamagedSnapshotThrowsInsteadOfTrapping() throws {
+        let data = APDUSnapshotFormat.encode(makeOperations(count: 2, durationsCount: 3), deviceIdentifier: device.id)
+        
+        for length in 0..<data.count {
+            XCTAssertThrowsError(try APDUTestSourceSnapshot(data: data.prefix(length)).getAPDUTestOperations(for: device), "\(length)")
+        }
+        
+        // a flipped bit either throws or decodes other values, it must never crash
+        for index in data.indices {
+            for bit in 0..<8 {
+                var flipped = data
+                flipped[index] ^= 1 << bit
+                _ = try? APDUTestSourceSnapshot(data: flipped).getAPDUTestOperations(for: device)
+            }
+        }
+        
+        // count and table offset far past the snapshot
+        for (offset, value) in [(24, UInt64.max), (24, UInt64(Int.max / 8)), (32, UInt64.max), (32, UInt64(Int.max))] {
+            var damaged = data
+            damaged.replaceSubrange(offset..<offset + 8, with: Swift.withUnsafeBytes(of: value.littleEndian) { Data($0) })
+            
+            XCTAssertThrowsError(try APDUSnapshotArchive(data: damaged), "\(offset)")
+        }
+    }
+    
+    func testPerformanceBinarySnapshot() throws {
+        let operations = makeOperations(count: 500, durationsCount: 1_000)
+        
+        self.measure {
+            let data = APDUSnapshotFormat.encode(operations, deviceIdentifier: device.id)
+            _ = try? APDUTestSourceSnapshot(data: data).getAPDUTestOperations(for: device)
+        }
+    }
+    
+    func testPerformanceJSONSnapshot() throws {
+        let operations = makeOperations(count: 500, durationsCount: 1_000)
+        
+        self.measure {
+            let data = try? APDUTestSourceSnapshot.data(for: operations, deviceIdentifier: device.id, format: .json)
+            _ = try? APDUTestSourceSnapshot(data: data ?? Data()).getAPDUTestOperations(for: device)
+        }
+    }
+}
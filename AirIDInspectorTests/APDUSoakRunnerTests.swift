@@ -0,0 +1,98 @@
+//
+//  APDUSoakRunnerTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class APDUSoakRunnerTests: XCTestCase {
+    
+    /// Drops after a few APDUs on every connection, and fails some APDUs without dropping.
+    private final class FlakyDevice: MockedDevice {
+        var answersPerConnection = 3
+        var transientFailures = 0
+        
+        override func sendAPDU(with data: Data) async throws -> Data {
+            if transientFailures > 0 {
+                transientFailures -= 1
+                throw URLError(.timedOut)
+            }
+            
+            return try await super.sendAPDU(with: data)
+        }
+        
+        override func connect() async throws {
+            disconnectsAfter = answersPerConnection
+            try await super.connect()
+        }
+    }
+    
+    private func makeDevice() -> FlakyDevice {
+        let device = FlakyDevice(id: UUID(), signalStrength: .medium, status: .connected)
+        device.responseDelay = 1_000...1_000
+        device.setNextExpectedResponse(Data([0x90, 0x00]))
+        return device
+    }
+    
+    private func makeTable() -> APDUOperationTable {
+        APDUOperationTable(entries: [.selectATR(nil),
+                                     .test(command: "00B0000000".hexadecimal!, expectedResponse: "9000"),
+                                     .test(command: "00B0000100".hexadecimal!, expectedResponse: "9000")])
+    }
+    
+    private func makeRunner(iterations: Int) -> APDUSoakRunner {
+        var runner = APDUSoakRunner(budget: .iterations(iterations))
+        runner.initialBackoff = 1_000_000
+        return runner
+    }
+    
+    func testWindowsAreBounded() {
+        var report = APDUSoakReport(windowDuration: 10, capacity: 3, startedAt: 0)
+        for time in UInt64(0)..<100 {
+            report.record(sentAt: time, receivedAt: time, matches: time != 95)
+        }
+        
+        XCTAssertEqual(report.windows.map(\.sequence), [7, 8, 9])
+        XCTAssertEqual(report.windows.last?.mismatchesCount, 1)
+        XCTAssertEqual(report.recent.latencies.count, 30)
+        XCTAssertEqual(report.total.latencies.count, 100)
+        
+        // a long pause leaves empty windows behind, still only as many as kept
+        report.recordReconnect(at: 1_000)
+        XCTAssertEqual(report.windows.map(\.sequence), [98, 99, 100])
+        XCTAssertEqual(report.recent.latencies.count, 0)
+        XCTAssertEqual(report.total.reconnectsCount, 1)
+    }
+    
+    @MainActor
+    func testReconnectsAfterDrops() async throws {
+        let device = makeDevice()
+        device.disconnectsAfter = device.answersPerConnection
+        
+        let report = try await makeRunner(iterations: 5).run(makeTable(), on: device)
+        
+        // every connection completes one iteration and drops in the middle of the next
+        XCTAssertEqual(report.iterationsCount, 5)
+        XCTAssertEqual(report.total.reconnectsCount, 4)
+        XCTAssertEqual(report.total.failuresCount, 4)
+        XCTAssertEqual(report.total.retriesCount, 0)
+        XCTAssertEqual(report.total.latencies.count, 14)
+        XCTAssertEqual(report.total.mismatchesCount, 0)
+    }
+    
+    @MainActor
+    func testRetriesTransientFailures() async throws {
+        let device = makeDevice()
+        device.transientFailures = 2
+        
+        let report = try await makeRunner(iterations: 2).run(makeTable(), on: device)
+        
+        XCTAssertEqual(report.iterationsCount, 2)
+        XCTAssertEqual(report.total.retriesCount, 2)
+        XCTAssertEqual(report.total.failuresCount, 0)
+        XCTAssertEqual(report.total.latencies.count, 4)
+    }
+}
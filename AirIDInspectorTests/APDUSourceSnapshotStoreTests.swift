@@ -0,0 +1,109 @@
+//
+//  APDUSourceSnapshotStoreTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class APDUSourceSnapshotStoreTests: XCTestCase {
+    
+    var device: MockedDevice!
+    var fileURL: URL!
+    
+    override func setUpWithError() throws {
+        self.device = MockedDevice(id: UUID(),
+                                   signalStrength: .medium,
+                                   status: .initialized)
+        
+        self.fileURL = FileManager.default.temporaryDirectory
+            .appendingPathComponent(UUID().uuidString)
+            .appendingPathComponent("snapshots.log")
+    }
+    
+    override func tearDownWithError() throws {
+        try? FileManager.default.removeItem(at: fileURL.deletingLastPathComponent())
+    }
+    
+    func makeOperations(count: Int) -> [APDUBaseOperation] {
+        (0..<count).map { index in
+            let operation = APDUTestOperation(device: device,
+                                              data: "00B0\(String(format: "%04X", index))00".hexadecimal!,
+                                              expectedResponse: "9000")
+            operation.measurements.append(duration: UInt64(index) * 1_000)
+            return operation
+        }
+    }
+    
+    func testSnapshotsSurviveReopening() async throws {
+        let operations = makeOperations(count: 10)
+        
+        let store = APDUSourceSnapshotStore(fileURL: fileURL)
+        try await store.store(operations: makeOperations(count: 3), for: device.id)
+        try await store.store(operations: operations, for: device.id)
+        
+        let reopened = APDUSourceSnapshotStore(fileURL: fileURL)
+        let restored = try await reopened.snapshot(for: device.id)?.getAPDUTestOperations(for: device)
+        
+        XCTAssertEqual(restored?.map(\.id), operations.map(\.id))
+        XCTAssertEqual(restored?.map(\.measurements.durations), operations.map(\.measurements.durations))
+        
+        let unknown = await reopened.snapshot(for: UUID())
+        XCTAssertNil(unknown)
+    }
+    
+    func testTornRecordIsDropped() async throws {
+        let store = APDUSourceSnapshotStore(fileURL: fileURL)
+        try await store.store(operations: makeOperations(count: 2), for: device.id)
+        
+        // a crash while appending leaves a partial record behind
+        let handle = try FileHandle(forWritingTo: fileURL)
+        try handle.seekToEnd()
+        try handle.write(contentsOf: Data(repeating: 0xAB, count: 30))
+        try handle.close()
+        
+        let reopened = APDUSourceSnapshotStore(fileURL: fileURL)
+        let restored = try await reopened.snapshot(for: device.id)?.getAPDUTestOperations(for: device)
+        XCTAssertEqual(restored?.count, 2)
+    }
+    
+    func testEvictionKeepsSnapshotsReadable() async throws {
+        let store = APDUSourceSnapshotStore(fileURL: fileURL, memoryBudget: 1)
+        let identifiers = (0..<5).map { _ in UUID() }
+        
+        for identifier in identifiers {
+            try await store.store(operations: makeOperations(count: 4), for: identifier)
+        }
+        
+        for identifier in identifiers {
+            let data = try await store.snapshotData(for: identifier)
+            XCTAssertNotNil(data)
+        }
+    }
+    
+    func testCompactionKeepsLatestSnapshots() async throws {
+        let store = APDUSourceSnapshotStore(fileURL: fileURL)
+        let other = UUID()
+        
+        for count in 1...20 {
+            try await store.store(operations: makeOperations(count: count), for: device.id)
+        }
+        
+        try await store.store(operations: makeOperations(count: 1), for: other)
+        
+        let sizeBefore = try FileManager.default.attributesOfItem(atPath: fileURL.path)[.size] as? Int ?? 0
+        try await store.compact()
+        let sizeAfter = try FileManager.default.attributesOfItem(atPath: fileURL.path)[.size] as? Int ?? 0
+        
+        XCTAssertLessThan(sizeAfter, sizeBefore)
+        
+        let reopened = APDUSourceSnapshotStore(fileURL: fileURL)
+        let latest = try await reopened.snapshot(for: device.id)?.getAPDUTestOperations(for: device)
+        let single = try await reopened.snapshot(for: other)?.getAPDUTestOperations(for: device)
+        
+        XCTAssertEqual(latest?.count, 20)
+        XCTAssertEqual(single?.count, 1)
+    }
+}
@@ -0,0 +1,74 @@
+//
+//  APDUTransactionTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class APDUTransactionTests: XCTestCase {
+    
+    var device: MockedDevice!
+    
+    override func setUpWithError() throws {
+        self.device = MockedDevice(id: UUID(), signalStrength: .medium, status: .connected)
+        device.responseDelay = 1_000_000...1_000_000
+        device.setNextExpectedResponse(Data([0x90, 0x00]))
+    }
+    
+    func testTransactionBlocksAreParsed() async throws {
+        let script = """
+        T=1
+        BEGIN TRANSACTION
+        00A4040000
+        9000
+        REPEAT 2
+        00B0000000
+        9000
+        END
+        END TRANSACTION RESET
+        """
+        
+        let operations = try APDUTestSourceString(string: script).getAPDUTestOperations(for: device)
+        XCTAssertEqual(operations.map(\.type), [.selectATR, .setProtocol, .transaction, .apduTest, .apduTest, .apduTest, .transaction])
+        XCTAssertEqual((operations.last as? APDUTransactionOperation)?.boundary, .end(.reset))
+        
+        let table = try await APDUTestSourceString(string: script, parsingMode: .sequential).loadAPDUOperationTable(for: device)
+        XCTAssertEqual(table.leadingHeaderRows, 0..<2)
+        XCTAssertEqual(table.transactionRows(in: table.indices), [2, 5])
+        XCTAssertEqual(table.name(at: 5), "End Transaction (Reset)..")
+        
+        // a reset at the end drops how the card was set up
+        var session = APDUCardSession()
+        table.leadingHeaderRows.forEach { session.apply($0, of: table) }
+        XCTAssertTrue(session.isRedundant(1, of: table))
+        session.apply(5, of: table)
+        XCTAssertFalse(session.isRedundant(1, of: table))
+    }
+    
+    func testBoundariesRoundTripThroughSnapshots() throws {
+        let operations = APDUOperationTable(entries: [.selectATR(nil), .transaction(.begin), .test(command: "00B0000000".hexadecimal!, expectedResponse: "9000"), .transaction(.end(.unpower))]).operations(for: device)
+        
+        let data = try APDUTestSourceSnapshot.data(for: operations, deviceIdentifier: device.id)
+        let decoded = try APDUTestSourceSnapshot(data: data).getAPDUTestOperations(for: device)
+        XCTAssertEqual(decoded.compactMap { ($0 as? APDUTransactionOperation)?.boundary }, [.begin, .end(.unpower)])
+        XCTAssertEqual(decoded.map(\.id), operations.map(\.id))
+    }
+    
+    @MainActor
+    func testHoldingTheCardSavesExclusiveAccess() async throws {
+        device.exclusiveAccessDelay = 2_000_000
+        let table = APDUOperationTable(entries: [.selectATR(nil)] + (0..<4).map { .test(command: "00B000\(String(format: "%02X", $0))00".hexadecimal!, expectedResponse: "9000") })
+        
+        let report = try await APDUTransactionBenchmark(rounds: 4).run(table, on: device)
+        
+        XCTAssertEqual(report.roundsCount, 4)
+        XCTAssertEqual(report.perCommand.count, 16)
+        XCTAssertEqual(report.transaction.count, 16)
+        XCTAssertEqual(report.overhead.count, 4)
+        XCTAssertGreaterThan(report.savedPerAPDU, 0)
+        XCTAssertFalse(device.isInTransaction)
+    }
+}
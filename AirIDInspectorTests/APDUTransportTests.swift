@@ -0,0 +1,129 @@
+//
+//  APDUTransportTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class APDUTransportTests: XCTestCase {
+    
+    /// Drives an exchange of `command` with `card` answering every command sent, returns it with what was sent.
+    private func run(_ command: Data, limits: APDULinkLimits = .minimum, card: (Data) -> Data) -> (APDUTransportExchange, [Data]) {
+        var exchange = APDUTransportExchange(command: command, limits: limits)
+        var sent: [Data] = []
+        
+        while let next = exchange.nextCommand {
+            sent.append(next)
+            exchange.receive(card(next))
+        }
+        
+        return (exchange, sent)
+    }
+    
+    func testCommandsParse() {
+        XCTAssertEqual(APDUCommand("00A4040007A000000003101000".hexadecimal!)?.body.count, 7)
+        XCTAssertEqual(APDUCommand("00A4040007A000000003101000".hexadecimal!)?.expectedLength, 256)
+        XCTAssertEqual(APDUCommand("00B0000000".hexadecimal!)?.expectedLength, 256)
+        XCTAssertEqual(APDUCommand("00B00000000400".hexadecimal!)?.expectedLength, 1024)
+        XCTAssertNil(APDUCommand("00A4040007A0".hexadecimal!))
+    }
+    
+    func testFittingCommandIsSentAsIs() {
+        let command = "00B0000010".hexadecimal!
+        let (exchange, sent) = run(command) { _ in "9000".hexadecimal! }
+        
+        XCTAssertEqual(sent, [command])
+        XCTAssertEqual(exchange.response, "9000".hexadecimal!)
+        XCTAssertEqual(exchange.roundTripsCount, 1)
+    }
+    
+    func testLongCommandIsChained() {
+        let body = Data((0..<600).map { UInt8($0 % 256) })
+        let command = Data([0x00, 0xDA, 0x01, 0x02, 0x00, 0x02, 0x58]) + body + Data([0x00, 0x00])
+        
+        let (exchange, sent) = run(command) { _ in "9000".hexadecimal! }
+        
+        XCTAssertEqual(sent.map { $0[0] }, [0x10, 0x10, 0x00])
+        XCTAssertEqual(sent.map { $0[4] }, [255, 255, 90])
+        XCTAssertEqual(sent.map(\.count), [260, 260, 96])
+        XCTAssertEqual(Data(sent.map { $0.dropFirst(5).prefix(Int($0[4])) }.joined()), body)
+        XCTAssertEqual(exchange.roundTripsCount, 3)
+    }
+    
+    func testRefusedSegmentEndsTheChain() {
+        let command = Data([0x00, 0xDA, 0x01, 0x02, 0x00, 0x02, 0x58]) + Data(count: 600)
+        let (exchange, sent) = run(command) { _ in "6A80".hexadecimal! }
+        
+        XCTAssertEqual(sent.count, 1)
+        XCTAssertEqual(exchange.response, "6A80".hexadecimal!)
+    }
+    
+    func testGetResponseIsLooped() {
+        let first = Data(repeating: 0xAA, count: 16)
+        let second = Data(repeating: 0xBB, count: 5)
+        
+        let (exchange, sent) = run("80CA9F7F00".hexadecimal!) { command in
+            switch command {
+            case "80CA9F7F00".hexadecimal!: return "6110".hexadecimal!
+            case "80C0000010".hexadecimal!: return first + "6105".hexadecimal!
+            case "80C0000005".hexadecimal!: return second + "9000".hexadecimal!
+            default: return "6D00".hexadecimal!
+            }
+        }
+        
+        // the class of the command is kept, only its chaining bit would be dropped
+        XCTAssertEqual(sent.dropFirst().map { $0[0] }, [0x80, 0x80])
+        XCTAssertEqual(exchange.response, first + second + "9000".hexadecimal!)
+        XCTAssertEqual(exchange.roundTripsCount, 3)
+    }
+    
+    func testGetResponseIsBoundedByTheLink() {
+        let limits = APDULinkLimits(commandSize: 266, responseSize: 130)
+        let (_, sent) = run("00B0000000".hexadecimal!, limits: limits) { command in
+            command[1] == 0xC0 ? "9000".hexadecimal! : "6100".hexadecimal!
+        }
+        
+        XCTAssertEqual(sent.last, "00C0000080".hexadecimal!)
+    }
+    
+    func testWrongLengthIsCorrectedOnce() {
+        let (exchange, sent) = run("00B0000000".hexadecimal!) { command in
+            command == "00B0000008".hexadecimal! ? Data(count: 8) + "9000".hexadecimal! : "6C08".hexadecimal!
+        }
+        
+        XCTAssertEqual(sent, ["00B0000000".hexadecimal!, "00B0000008".hexadecimal!])
+        XCTAssertEqual(exchange.response?.count, 10)
+        
+        // a card asking again doesn't loop
+        let (stubborn, _) = run("00B0000000".hexadecimal!) { _ in "6C08".hexadecimal! }
+        XCTAssertEqual(stubborn.roundTripsCount, 2)
+        XCTAssertEqual(stubborn.response, "6C08".hexadecimal!)
+    }
+    
+    func testWrongLengthKeepsAnExtendedCommandExtended() {
+        let (read, sentReads) = run("00B00000000400".hexadecimal!) { command in
+            command.count == 7 && command[6] == 0x80 ? Data(count: 0x80) + "9000".hexadecimal! : "6C80".hexadecimal!
+        }
+        
+        XCTAssertEqual(sentReads.last, "00B00000000080".hexadecimal!)
+        XCTAssertEqual(read.response?.count, 0x82)
+        
+        // a body longer than a short Lc fits a link which takes it
+        let body = Data(repeating: 0x5A, count: 400)
+        let limits = APDULinkLimits(commandSize: 1024, responseSize: 1024)
+        let (_, sentUpdates) = run(Data([0x00, 0xDA, 0x01, 0x02, 0x00, 0x01, 0x90]) + body + Data([0x00, 0x00]), limits: limits) { command in
+            command.suffix(2) == Data([0x00, 0x10]) ? Data(count: 0x10) + "9000".hexadecimal! : "6C10".hexadecimal!
+        }
+        
+        XCTAssertEqual(sentUpdates.count, 2)
+        XCTAssertEqual(sentUpdates.last, Data([0x00, 0xDA, 0x01, 0x02, 0x00, 0x01, 0x90]) + body + Data([0x00, 0x10]))
+    }
+    
+    func testLimitsFollowTheDataBuffer() {
+        XCTAssertEqual(APDULinkLimits(commandSize: 0, responseSize: 0), .minimum)
+        XCTAssertEqual(APDULinkLimits(commandSize: 1024, responseSize: 1024, dataBufferSize: 300).commandSize, 300)
+    }
+}
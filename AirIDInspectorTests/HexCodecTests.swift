@@ -0,0 +1,88 @@
+//
+//  HexCodecTests.swift
+//  AirIDDemoTests
+//
+//  Created by Hussein AlRyalat on 17/10/2026.
+//
+
+import XCTest
+@testable import AirIDDemo
+
+final class HexCodecTests: XCTestCase {
+    
+    /// A script sized sample, one request/response pair per two lines.
+    lazy var lines: [String] = (0..<20_000).flatMap { index in
+        ["00A4040009A000000308\(String(format: "%08X", index))", index.isMultiple(of: 3) ? "6A82" : "9000"]
+    }
+    
+    func testDecodingKeepsTolerantSemantics() {
+        let samples = ["", "9000", "6a82", "A1000", "6...", "<00 A4 04 00>", "0g1", "a b c",
+                       "00A404000BA0000003974349445F0100", "00a404000ba0000003974349445f0100ffee", "ÄA1ü0"]
+        
+        for sample in samples {
+            XCTAssertEqual(sample.hexadecimal, Self.legacyHexadecimal(sample), sample)
+            XCTAssertEqual(sample[...].hexadecimal, Self.legacyHexadecimal(sample), sample)
+        }
+    }
+    
+    func testEncodingMatchesFormat() {
+        let data = Data((0...255).map { UInt8($0) } + [0x00, 0xA4, 0x04])
+        
+        XCTAssertEqual(data.hexEncodedString(), Self.legacyHexEncodedString(data, format: "%02hhX"))
+        XCTAssertEqual(data.hexEncodedString(options: []), Self.legacyHexEncodedString(data, format: "%02hhx"))
+        XCTAssertEqual(Data().hexEncodedString(), "")
+    }
+    
+    func testRoundTrip() {
+        for line in lines.prefix(100) {
+            XCTAssertEqual(line.hexadecimal?.hexEncodedString(), line.uppercased())
+        }
+    }
+    
+    func testPerformanceDecoding() {
+        self.measure {
+            lines.forEach { _ = $0.hexadecimal }
+        }
+    }
+    
+    func testPerformanceLegacyDecoding() {
+        self.measure {
+            lines.forEach { _ = Self.legacyHexadecimal($0) }
+        }
+    }
+    
+    func testPerformanceEncoding() {
+        let payloads = lines.compactMap { $0.hexadecimal }
+        self.measure {
+            payloads.forEach { _ = $0.hexEncodedString() }
+        }
+    }
+    
+    func testPerformanceLegacyEncoding() {
+        let payloads = lines.compactMap { $0.hexadecimal }
+        self.measure {
+            payloads.forEach { _ = Self.legacyHexEncodedString($0, format: "%02hhX") }
+        }
+    }
+    
+    // MARK: - Previous implementation, kept as reference and baseline
+    
+    static func legacyHexadecimal(_ string: String) -> Data? {
+        var data = Data(capacity: string.count / 2)
+        
+        let regex = try! NSRegularExpression(pattern: "[0-9a-f]{1,2}", options: .caseInsensitive)
+        regex.enumerateMatches(in: string, range: NSRange(string.startIndex..., in: string)) { match, _, _ in
+            let byteString = (string as NSString).substring(with: match!.range)
+            let num = UInt8(byteString, radix: 16)!
+            data.append(num)
+        }
+        
+        guard data.count > 0 else { return nil }
+        
+        return data
+    }
+    
+    static func legacyHexEncodedString(_ data: Data, format: String) -> String {
+        data.map { String(format: format, $0) }.joined()
+    }
+}